@@ -5,433 +5,6567 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <stdexcept>
+#include <limits>
+#include <chrono>
+#include <random>
+#include <array>
+#include <utility>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <type_traits>
+#include <memory_resource>
+#include <iterator>
+#include <fstream>
+#include <cmath>
+
+// The limb kernels pick the fastest instruction set the CPU supports at startup. Build with
+// -DBIGNUMBER_FORCE_KERNEL=BIGNUMBER_KERNEL_SCALAR (or _ADX, _AVX2, _AVX512) to pin one path instead.
+#define BIGNUMBER_KERNEL_SCALAR 0
+#define BIGNUMBER_KERNEL_ADX 1
+#define BIGNUMBER_KERNEL_AVX2 2
+#define BIGNUMBER_KERNEL_AVX512 3
+
+// Build with -DBIGNUMBER_INSTRUMENTATION=1 to count calls, operand sizes, cycles, limb allocations and division by
+// zero events per thread (see BigNumber::statistics()). When it is off the probes compile to nothing.
+#ifndef BIGNUMBER_INSTRUMENTATION
+#define BIGNUMBER_INSTRUMENTATION 0
+#endif
+
+// Limbs a BigNumber keeps inline before its storage spills to the heap (at least 1)
+#ifndef BIGNUMBER_INLINE_LIMBS
+#define BIGNUMBER_INLINE_LIMBS 4
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BIGNUMBER_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+class MontgomeryContext;
+class MontgomeryLanes;
+class Reducer;
+class RsaPrivateKey;
+class BatchExecutor;
+struct LazyOperand;
+template <typename Node>
+class LazyExpression;
+class LazyEvaluator;
 
 class BigNumber
 {
+    friend class MontgomeryContext;
+    friend class MontgomeryLanes;
+    friend class Reducer;
+    friend class RsaPrivateKey;
+    friend class LazyEvaluator;
+    template <size_t Bits>
+    friend class FixedBigNumber;
+
+public:
+    // A single base 2^64 limb and the double width type used by the carry kernels
+    using Limb = std::uint64_t;
+    using DoubleLimb = unsigned __int128;
+
+    // Limb storage allocations made on one thread, see allocationStats()
+    struct AllocationStats
+    {
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t bytes = 0;
+    };
+
+    // Allocator behind every limb vector. Blocks come from the calling thread's current memory resource (see
+    // limbResource()) and record it in a small header, so each block goes back to the resource it came from no
+    // matter which thread or scope frees it.
+    template <typename T>
+    class LimbAllocator
+    {
+    public:
+        using value_type = T;
+
+        LimbAllocator() = default;
+
+        template <typename U>
+        LimbAllocator(const LimbAllocator<U> &)
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            if (n > (std::numeric_limits<size_t>::max() - HEADER) / sizeof(T))
+            {
+                throw std::bad_array_new_length();
+            }
+            std::pmr::memory_resource *resource = limbResource();
+            char *block = static_cast<char *>(resource->allocate(HEADER + n * sizeof(T), HEADER));
+            *reinterpret_cast<std::pmr::memory_resource **>(block) = resource;
+            AllocationStats &stats = threadAllocationStats();
+            ++stats.allocations;
+            stats.bytes += n * sizeof(T);
+            countAllocation();
+            return reinterpret_cast<T *>(block + HEADER);
+        }
+
+        void deallocate(T *p, size_t n)
+        {
+            char *block = reinterpret_cast<char *>(p) - HEADER;
+            std::pmr::memory_resource *resource = *reinterpret_cast<std::pmr::memory_resource **>(block);
+            resource->deallocate(block, HEADER + n * sizeof(T), HEADER);
+            ++threadAllocationStats().deallocations;
+        }
+
+        template <typename U>
+        bool operator==(const LimbAllocator<U> &) const
+        {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const LimbAllocator<U> &) const
+        {
+            return false;
+        }
+
+    private:
+        static constexpr size_t HEADER = alignof(std::max_align_t);
+    };
+
+    static constexpr size_t INLINE_LIMBS = BIGNUMBER_INLINE_LIMBS;
+    static_assert(INLINE_LIMBS > 0, "BIGNUMBER_INLINE_LIMBS must be at least 1");
+
+    // Vector of limbs with room for INLINE_LIMBS limbs inside the object, so small values such as 0, 1 and single
+    // limb probes never touch the allocator. Longer contents spill to storage from LimbAllocator. Supports the
+    // subset of the std::vector interface the library uses; new elements are zero initialized.
+    class LimbVector
+    {
+    public:
+        using value_type = Limb;
+        using size_type = size_t;
+        using iterator = Limb *;
+        using const_iterator = const Limb *;
+
+        LimbVector() = default;
+
+        explicit LimbVector(size_t n, Limb value = 0)
+        {
+            assign(n, value);
+        }
+
+        template <typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+        LimbVector(Iterator first, Iterator last)
+        {
+            assign(first, last);
+        }
+
+        LimbVector(std::initializer_list<Limb> values)
+        {
+            assign(values.begin(), values.end());
+        }
+
+        LimbVector(const LimbVector &other)
+        {
+            assign(other.begin(), other.end());
+        }
+
+        LimbVector(LimbVector &&other) noexcept
+        {
+            take(other);
+        }
+
+        ~LimbVector()
+        {
+            release();
+        }
+
+        LimbVector &operator=(const LimbVector &other)
+        {
+            if (this != &other)
+            {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        // Heap storage changes hands; inline contents are copied so that this keeps any capacity it has
+        LimbVector &operator=(LimbVector &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (other.onHeap())
+                {
+                    release();
+                    take(other);
+                }
+                else
+                {
+                    std::copy(other.begin(), other.end(), limbs);
+                    count = other.count;
+                    other.count = 0;
+                }
+            }
+            return *this;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        size_t capacity() const
+        {
+            return allocated;
+        }
+
+        Limb *data()
+        {
+            return limbs;
+        }
+
+        const Limb *data() const
+        {
+            return limbs;
+        }
+
+        Limb *begin()
+        {
+            return limbs;
+        }
+
+        Limb *end()
+        {
+            return limbs + count;
+        }
+
+        const Limb *begin() const
+        {
+            return limbs;
+        }
+
+        const Limb *end() const
+        {
+            return limbs + count;
+        }
+
+        Limb &operator[](size_t i)
+        {
+            return limbs[i];
+        }
+
+        const Limb &operator[](size_t i) const
+        {
+            return limbs[i];
+        }
+
+        Limb &back()
+        {
+            return limbs[count - 1];
+        }
+
+        const Limb &back() const
+        {
+            return limbs[count - 1];
+        }
+
+        void push_back(Limb value)
+        {
+            if (count == allocated)
+            {
+                grow(2 * allocated);
+            }
+            limbs[count++] = value;
+        }
+
+        void pop_back()
+        {
+            --count;
+        }
+
+        void clear()
+        {
+            count = 0;
+        }
+
+        void reserve(size_t n)
+        {
+            if (n > allocated)
+            {
+                grow(n);
+            }
+        }
+
+        void resize(size_t n, Limb value = 0)
+        {
+            reserve(n);
+            if (n > count)
+            {
+                std::fill(limbs + count, limbs + n, value);
+            }
+            count = n;
+        }
+
+        void assign(size_t n, Limb value)
+        {
+            discardFor(n);
+            std::fill(limbs, limbs + n, value);
+            count = n;
+        }
+
+        template <typename Iterator, typename = typename std::iterator_traits<Iterator>::iterator_category>
+        void assign(Iterator first, Iterator last)
+        {
+            const size_t n = std::distance(first, last);
+            discardFor(n);
+            std::copy(first, last, limbs);
+            count = n;
+        }
+
+        bool operator==(const LimbVector &other) const
+        {
+            return count == other.count && std::equal(begin(), end(), other.begin());
+        }
+
+        bool operator!=(const LimbVector &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        Limb *limbs = inline_limbs;
+        size_t count = 0;
+        size_t allocated = INLINE_LIMBS;
+        Limb inline_limbs[INLINE_LIMBS];
+
+        bool onHeap() const
+        {
+            return limbs != inline_limbs;
+        }
+
+        void release()
+        {
+            if (onHeap())
+            {
+                LimbAllocator<Limb>().deallocate(limbs, allocated);
+                limbs = inline_limbs;
+                allocated = INLINE_LIMBS;
+            }
+        }
+
+        void take(LimbVector &other)
+        {
+            if (other.onHeap())
+            {
+                limbs = other.limbs;
+                allocated = other.allocated;
+                other.limbs = other.inline_limbs;
+                other.allocated = INLINE_LIMBS;
+            }
+            else
+            {
+                std::copy(other.begin(), other.end(), inline_limbs);
+            }
+            count = other.count;
+            other.count = 0;
+        }
+
+        // Move to storage for n limbs, keeping the contents
+        void grow(size_t n)
+        {
+            Limb *storage = LimbAllocator<Limb>().allocate(n);
+            std::copy(begin(), end(), storage);
+            release();
+            limbs = storage;
+            allocated = n;
+        }
+
+        // Make room for n limbs whose old contents are about to be overwritten. Assigning a range that lies
+        // inside this vector never needs more room, so the source stays intact.
+        void discardFor(size_t n)
+        {
+            if (n > allocated)
+            {
+                count = 0;
+                grow(std::max(n, 2 * allocated));
+            }
+        }
+    };
+
+    static constexpr int LIMB_BITS = 64;
+
+    // Operand sizes, in limbs, at which multiplication and squaring switch to Karatsuba, then to Toom-3 and then
+    // to the number theoretic transform
+    struct MultiplicationThresholds
+    {
+        size_t karatsuba = 24;
+        size_t toom3 = 768;
+        size_t ntt = 6144;
+        size_t karatsuba_square = 48;
+        size_t toom3_square = 768;
+        size_t ntt_square = 6144;
+    };
+
+    // Process wide thresholds; adjust them once at startup, e.g. with the values from tuneMultiplicationThresholds()
+    static MultiplicationThresholds &multiplicationThresholds()
+    {
+        static MultiplicationThresholds thresholds;
+        return thresholds;
+    }
+
+    // Time schoolbook, Karatsuba, Toom-3 and the NTT against each other on this machine, install the crossover
+    // points as the process wide thresholds and return them. Progress is written to log.
+    static MultiplicationThresholds tuneMultiplicationThresholds(std::ostream &log)
+    {
+        MultiplicationThresholds &thresholds = multiplicationThresholds();
+        const size_t never = std::numeric_limits<size_t>::max();
+        std::mt19937_64 generator(0x5eed);
+
+        // Average nanoseconds per n limb product (or square) under the current thresholds
+        auto time_product = [&generator](size_t n, bool square)
+        {
+            LimbVector a(n), b(n), r(2 * n), scratch(mulScratchSize(n));
+            for (size_t i = 0; i < n; ++i)
+            {
+                a[i] = generator();
+                b[i] = generator();
+            }
+
+            size_t iterations = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::nanoseconds elapsed(0);
+            do
+            {
+                mulBalanced(r.data(), a.data(), square ? nullptr : b.data(), n, scratch.data());
+                ++iterations;
+                elapsed = std::chrono::steady_clock::now() - start;
+            } while (elapsed < std::chrono::milliseconds(20));
+            return (double)elapsed.count() / iterations;
+        };
+
+        // Smallest candidate size at which one level of the faster algorithm beats the slower one
+        auto find_crossover = [&](const std::vector<size_t> &sizes, bool square, size_t &cutoff, const char *name)
+        {
+            for (size_t n : sizes)
+            {
+                cutoff = never;
+                double slower = time_product(n, square);
+                cutoff = n;
+                double faster = time_product(n, square);
+                log << name << " at " << n << " limbs: " << slower << " ns vs " << faster << " ns" << std::endl;
+                if (faster < slower)
+                {
+                    return;
+                }
+            }
+            cutoff = never;
+        };
+
+        thresholds.toom3 = never;
+        thresholds.toom3_square = never;
+        thresholds.ntt = never;
+        thresholds.ntt_square = never;
+        find_crossover({8, 12, 16, 20, 24, 28, 32, 40, 48, 64, 80, 96, 128}, false, thresholds.karatsuba, "karatsuba");
+        find_crossover({8, 12, 16, 20, 24, 28, 32, 40, 48, 64, 80, 96, 128}, true, thresholds.karatsuba_square, "karatsuba square");
+        find_crossover({64, 96, 128, 160, 192, 256, 320, 384, 512, 768}, false, thresholds.toom3, "toom3");
+        find_crossover({64, 96, 128, 160, 192, 256, 320, 384, 512, 768}, true, thresholds.toom3_square, "toom3 square");
+        find_crossover({512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192}, false, thresholds.ntt, "ntt");
+        find_crossover({512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192}, true, thresholds.ntt_square, "ntt square");
+
+        log << "karatsuba=" << thresholds.karatsuba << " toom3=" << thresholds.toom3 << " ntt=" << thresholds.ntt
+            << " karatsuba_square=" << thresholds.karatsuba_square << " toom3_square=" << thresholds.toom3_square
+            << " ntt_square=" << thresholds.ntt_square << std::endl;
+        return thresholds;
+    }
+
+    // Instruction set used by the add, subtract and multiply-accumulate limb kernels
+    enum class LimbKernel
+    {
+        Scalar, // portable C++
+        Adx,    // add with carry flag chains, MULX/ADCX/ADOX multiply rows
+        Avx2,   // 4 lane vector add/subtract with carry lookahead
+        Avx512  // 8 lane vector add/subtract with carry lookahead
+    };
+
+    // Kernel chosen for this process, either detected with CPUID or forced at build time
+    static LimbKernel limbKernel()
+    {
+        return limbKernels().kind;
+    }
+
+    static const char *limbKernelName(LimbKernel kernel)
+    {
+        switch (kernel)
+        {
+        case LimbKernel::Adx:
+            return "adx";
+        case LimbKernel::Avx2:
+            return "avx2";
+        case LimbKernel::Avx512:
+            return "avx512";
+        default:
+            return "scalar";
+        }
+    }
+
+    // Memory resource that new limb storage on this thread comes from: the innermost LimbResourceScope, or else
+    // the process default
+    static std::pmr::memory_resource *limbResource()
+    {
+        std::pmr::memory_resource *scoped = scopedLimbResource();
+        return scoped != nullptr ? scoped : defaultLimbResource().load(std::memory_order_relaxed);
+    }
+
+    // Set the process default resource for threads outside any scope; it starts as the global heap. The
+    // resource must be thread safe and outlive every number allocated from it.
+    static void setDefaultLimbResource(std::pmr::memory_resource *resource)
+    {
+        defaultLimbResource().store(resource != nullptr ? resource : std::pmr::new_delete_resource());
+    }
+
+    // Thread safe pool that keeps freed blocks in per thread free lists by power of two size class, so steady
+    // state allocation skips malloc. Suitable as the process default.
+    static std::pmr::memory_resource *limbPool()
+    {
+        static ThreadCachingPool pool;
+        return &pool;
+    }
+
+    // Route the limb allocations of the calling thread to a resource for the lifetime of the scope. With a
+    // std::pmr::monotonic_buffer_resource this makes an arena that is released in bulk when it is destroyed;
+    // numbers allocated from it must not outlive it.
+    class LimbResourceScope
+    {
+    public:
+        explicit LimbResourceScope(std::pmr::memory_resource *resource) : previous(scopedLimbResource())
+        {
+            scopedLimbResource() = resource;
+        }
+
+        ~LimbResourceScope()
+        {
+            scopedLimbResource() = previous;
+        }
+
+        LimbResourceScope(const LimbResourceScope &) = delete;
+        LimbResourceScope &operator=(const LimbResourceScope &) = delete;
+
+    private:
+        std::pmr::memory_resource *previous;
+    };
+
+    // Limb allocations made by the calling thread since it started
+    static AllocationStats allocationStats()
+    {
+        return threadAllocationStats();
+    }
+
+    // Counts the limb allocations the calling thread makes during its lifetime, e.g. around one operation or
+    // a hot loop that is expected to stay allocation free
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() : start(allocationStats())
+        {
+        }
+
+        size_t allocations() const
+        {
+            return allocationStats().allocations - start.allocations;
+        }
+
+        size_t deallocations() const
+        {
+            return allocationStats().deallocations - start.deallocations;
+        }
+
+        size_t bytes() const
+        {
+            return allocationStats().bytes - start.bytes;
+        }
+
+    private:
+        AllocationStats start;
+    };
+
+    // Free the scratch buffers the calling thread has pooled for the multiplication, division and inversion
+    // kernels. They are refilled on demand.
+    static void releaseScratch()
+    {
+        ScratchLimbs::release();
+    }
+
+    // Operations the instrumentation tracks. Times are inclusive, so a modPow also counts its multiplications.
+    enum class Operation
+    {
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        ModPow,
+        ModInverse
+    };
+    static constexpr size_t OPERATIONS = 6;
+
+    // Operand sizes are histogrammed by limb count in power of two buckets: bucket i holds sizes in
+    // [2^i, 2^(i+1)) limbs and the last one everything larger
+    static constexpr size_t SIZE_BUCKETS = 16;
+
+    static constexpr bool instrumentationEnabled = BIGNUMBER_INSTRUMENTATION != 0;
+
+    struct OperationStatistics
+    {
+        uint64_t calls = 0;
+        uint64_t cycles = 0; // time stamp counter ticks on x86, nanoseconds elsewhere
+        std::array<uint64_t, SIZE_BUCKETS> sizes{};
+    };
+
+    struct Statistics
+    {
+        std::array<OperationStatistics, OPERATIONS> operations{};
+        uint64_t allocations = 0;
+        uint64_t division_by_zero = 0;
+
+        const OperationStatistics &operator[](Operation operation) const
+        {
+            return operations[size_t(operation)];
+        }
+    };
+
+    static const char *operationName(Operation operation)
+    {
+        static const char *const names[OPERATIONS] = {"add", "subtract", "multiply", "divide", "modPow", "modInverse"};
+        return names[size_t(operation)];
+    }
+
+    // Counters of every thread summed since the last resetStatistics(); all zero when instrumentation is off.
+    // Each thread writes only its own counters and this only reads them, so neither side takes a lock. Counts
+    // from threads that have exited are kept.
+    static Statistics statistics()
+    {
+        Statistics result = instrumentationTotals();
+        const InstrumentationCounters &base = instrumentationBaseline();
+        for (size_t op = 0; op < OPERATIONS; ++op)
+        {
+            result.operations[op].calls -= base.calls[op].load(std::memory_order_relaxed);
+            result.operations[op].cycles -= base.cycles[op].load(std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < SIZE_BUCKETS; ++bucket)
+            {
+                result.operations[op].sizes[bucket] -= base.sizes[op][bucket].load(std::memory_order_relaxed);
+            }
+        }
+        result.allocations -= base.allocations.load(std::memory_order_relaxed);
+        result.division_by_zero -= base.division_by_zero.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // Start the statistics from zero. The counters themselves keep running and the current totals become the
+    // baseline, so threads never see their counters change under them.
+    static void resetStatistics()
+    {
+        const Statistics totals = instrumentationTotals();
+        InstrumentationCounters &base = instrumentationBaseline();
+        for (size_t op = 0; op < OPERATIONS; ++op)
+        {
+            base.calls[op].store(totals.operations[op].calls, std::memory_order_relaxed);
+            base.cycles[op].store(totals.operations[op].cycles, std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < SIZE_BUCKETS; ++bucket)
+            {
+                base.sizes[op][bucket].store(totals.operations[op].sizes[bucket], std::memory_order_relaxed);
+            }
+        }
+        base.allocations.store(totals.allocations, std::memory_order_relaxed);
+        base.division_by_zero.store(totals.division_by_zero, std::memory_order_relaxed);
+    }
+
+private:
+    // One thread's counters. Nodes are linked into a list that only grows; a node is owned by one thread at a
+    // time, which updates it with plain relaxed stores, and is handed on to a new thread when its owner exits.
+    struct InstrumentationCounters
+    {
+        std::atomic<uint64_t> calls[OPERATIONS] = {};
+        std::atomic<uint64_t> cycles[OPERATIONS] = {};
+        std::atomic<uint64_t> sizes[OPERATIONS][SIZE_BUCKETS] = {};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> division_by_zero{0};
+        std::atomic<bool> owned{true};
+        InstrumentationCounters *next = nullptr;
+    };
+
+    static std::atomic<InstrumentationCounters *> &instrumentationList()
+    {
+        static std::atomic<InstrumentationCounters *> head{nullptr};
+        return head;
+    }
+
+    // Totals taken by the last resetStatistics(), in atomics so that a reset may race with a snapshot
+    static InstrumentationCounters &instrumentationBaseline()
+    {
+        static InstrumentationCounters baseline;
+        return baseline;
+    }
+
+    static Statistics instrumentationTotals()
+    {
+        Statistics totals;
+        for (InstrumentationCounters *node = instrumentationList().load(std::memory_order_acquire); node != nullptr;
+             node = node->next)
+        {
+            for (size_t op = 0; op < OPERATIONS; ++op)
+            {
+                totals.operations[op].calls += node->calls[op].load(std::memory_order_relaxed);
+                totals.operations[op].cycles += node->cycles[op].load(std::memory_order_relaxed);
+                for (size_t bucket = 0; bucket < SIZE_BUCKETS; ++bucket)
+                {
+                    totals.operations[op].sizes[bucket] += node->sizes[op][bucket].load(std::memory_order_relaxed);
+                }
+            }
+            totals.allocations += node->allocations.load(std::memory_order_relaxed);
+            totals.division_by_zero += node->division_by_zero.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+    // The calling thread's counters, claiming a node left by an exited thread or pushing a new one on first use.
+    // Returns null once the thread has started exiting, so late events from other thread_local destructors are
+    // dropped instead of touching a node that may already belong to another thread.
+    static InstrumentationCounters *threadCounters()
+    {
+        // Trivially destructible, so still valid while the releaser below and other thread_locals are destroyed
+        thread_local InstrumentationCounters *counters = nullptr;
+        thread_local bool exiting = false;
+        if (counters != nullptr || exiting)
+        {
+            return counters;
+        }
+
+        std::atomic<InstrumentationCounters *> &head = instrumentationList();
+        for (InstrumentationCounters *node = head.load(std::memory_order_acquire); node != nullptr; node = node->next)
+        {
+            bool expected = false;
+            if (node->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                counters = node;
+                break;
+            }
+        }
+        if (counters == nullptr)
+        {
+            counters = new InstrumentationCounters();
+            counters->next = head.load(std::memory_order_relaxed);
+            while (!head.compare_exchange_weak(counters->next, counters, std::memory_order_release,
+                                               std::memory_order_relaxed))
+            {
+            }
+        }
+
+        struct Releaser
+        {
+            ~Releaser()
+            {
+                exiting = true;
+                InstrumentationCounters *node = counters;
+                counters = nullptr;
+                node->owned.store(false, std::memory_order_release);
+            }
+        };
+        thread_local Releaser releaser;
+        (void)releaser;
+        return counters;
+    }
+
+    // Only the owning thread writes a counter, so a load and a store replace the locked read-modify-write
+    static void bump(std::atomic<uint64_t> &counter, uint64_t amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static size_t sizeBucket(size_t limbs)
+    {
+        size_t bucket = 0;
+        while (limbs > 1 && bucket + 1 < SIZE_BUCKETS)
+        {
+            limbs >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    static uint64_t cycleCounter()
+    {
+#ifdef BIGNUMBER_X86_KERNELS
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    static void countAllocation()
+    {
+#if BIGNUMBER_INSTRUMENTATION
+        if (InstrumentationCounters *counters = threadCounters())
+        {
+            bump(counters->allocations, 1);
+        }
+#endif
+    }
+
+    static void countDivisionByZero()
+    {
+#if BIGNUMBER_INSTRUMENTATION
+        if (InstrumentationCounters *counters = threadCounters())
+        {
+            bump(counters->division_by_zero, 1);
+        }
+#endif
+    }
+
+    // Times one operation on the calling thread's counters for its lifetime; empty when instrumentation is off
+    class OperationProbe
+    {
+    public:
+#if BIGNUMBER_INSTRUMENTATION
+        OperationProbe(Operation operation, size_t limbs)
+            : counters(threadCounters()), index(size_t(operation)), bucket(sizeBucket(limbs)), start(cycleCounter())
+        {
+        }
+
+        ~OperationProbe()
+        {
+            if (counters != nullptr)
+            {
+                bump(counters->calls[index], 1);
+                bump(counters->cycles[index], cycleCounter() - start);
+                bump(counters->sizes[index][bucket], 1);
+            }
+        }
+
+        OperationProbe(const OperationProbe &) = delete;
+        OperationProbe &operator=(const OperationProbe &) = delete;
+
+    private:
+        InstrumentationCounters *counters;
+        size_t index;
+        size_t bucket;
+        uint64_t start;
+#else
+        OperationProbe(Operation, size_t)
+        {
+        }
+#endif
+    };
+
+    static AllocationStats &threadAllocationStats()
+    {
+        thread_local AllocationStats stats;
+        return stats;
+    }
+
+    static std::pmr::memory_resource *&scopedLimbResource()
+    {
+        thread_local std::pmr::memory_resource *resource = nullptr;
+        return resource;
+    }
+
+    static std::atomic<std::pmr::memory_resource *> &defaultLimbResource()
+    {
+        static std::atomic<std::pmr::memory_resource *> resource(std::pmr::new_delete_resource());
+        return resource;
+    }
+
+    // Free lists live in a trivially destructible thread_local so that blocks freed by other thread_local
+    // destructors after the flush still find valid storage; once flushed they go straight back to the heap.
+    class ThreadCachingPool : public std::pmr::memory_resource
+    {
+    private:
+        static constexpr int MIN_CLASS_BITS = 6;  // 64 bytes
+        static constexpr int MAX_CLASS_BITS = 16; // 64 KiB
+        static constexpr size_t CLASSES = MAX_CLASS_BITS - MIN_CLASS_BITS + 1;
+        static constexpr size_t BLOCKS_PER_CLASS = 32;
+
+        struct FreeLists
+        {
+            void *blocks[CLASSES][BLOCKS_PER_CLASS];
+            size_t counts[CLASSES];
+            bool flushed;
+        };
+
+        struct Flush
+        {
+            ~Flush()
+            {
+                FreeLists &lists = freeLists();
+                for (size_t c = 0; c < CLASSES; ++c)
+                {
+                    while (lists.counts[c] > 0)
+                    {
+                        ::operator delete(lists.blocks[c][--lists.counts[c]]);
+                    }
+                }
+                lists.flushed = true;
+            }
+        };
+
+        static FreeLists &freeLists()
+        {
+            thread_local FreeLists lists{};
+            return lists;
+        }
+
+        // Size class of a request, or CLASSES when it is too large to pool
+        static size_t sizeClass(size_t bytes)
+        {
+            int bits = MIN_CLASS_BITS;
+            while (bits <= MAX_CLASS_BITS && (size_t(1) << bits) < bytes)
+            {
+                ++bits;
+            }
+            return bits - MIN_CLASS_BITS;
+        }
+
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            size_t c = sizeClass(bytes);
+            if (alignment > alignof(std::max_align_t) || c == CLASSES)
+            {
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+            thread_local Flush flush;
+            (void)flush;
+            FreeLists &lists = freeLists();
+            if (lists.counts[c] > 0)
+            {
+                return lists.blocks[c][--lists.counts[c]];
+            }
+            return ::operator new(size_t(1) << (c + MIN_CLASS_BITS));
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            size_t c = sizeClass(bytes);
+            if (alignment > alignof(std::max_align_t) || c == CLASSES)
+            {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+                return;
+            }
+            // A thread may only ever free blocks that others allocated, so it needs the flush at exit as well
+            thread_local Flush flush;
+            (void)flush;
+            FreeLists &lists = freeLists();
+            if (!lists.flushed && lists.counts[c] < BLOCKS_PER_CLASS)
+            {
+                lists.blocks[c][lists.counts[c]++] = p;
+                return;
+            }
+            ::operator delete(p);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // Vector to store the limbs of the number in base 2^64 (least significant limb first)
+    LimbVector number_limbs;
+    bool isNegative = false;
+
+    // Largest power of ten that fits in a limb, used to convert to and from decimal
+    static constexpr Limb DECIMAL_CHUNK = 10000000000000000000ULL;
+    static constexpr int DECIMAL_CHUNK_DIGITS = 19;
+
+    // RAII loan of a limb buffer from a per thread pool. Buffers keep their capacity between loans, so once the
+    // pool has warmed up the kernels that need temporary space stop allocating. Loans nest, which the recursive
+    // multiplication algorithms rely on.
+    class ScratchLimbs
+    {
+    public:
+        explicit ScratchLimbs(size_t n) : buffer(acquire())
+        {
+            if (buffer.capacity() < n)
+            {
+                // Pooled buffers outlive any scoped resource, so they always come from the heap
+                LimbResourceScope heap(std::pmr::new_delete_resource());
+                buffer.reserve(n);
+            }
+            buffer.resize(n);
+        }
+
+        ~ScratchLimbs()
+        {
+            pool().push_back(std::move(buffer));
+        }
+
+        ScratchLimbs(const ScratchLimbs &) = delete;
+        ScratchLimbs &operator=(const ScratchLimbs &) = delete;
+
+        Limb *data()
+        {
+            return buffer.data();
+        }
+
+        // Drop the pooled buffers of the calling thread; buffers on loan return to the pool as usual
+        static void release()
+        {
+            std::vector<LimbVector>().swap(pool());
+        }
+
+    private:
+        LimbVector buffer;
+
+        static std::vector<LimbVector> &pool()
+        {
+            thread_local std::vector<LimbVector> buffers;
+            return buffers;
+        }
+
+        static LimbVector acquire()
+        {
+            std::vector<LimbVector> &buffers = pool();
+            if (buffers.empty())
+            {
+                return LimbVector();
+            }
+            LimbVector buffer = std::move(buffers.back());
+            buffers.pop_back();
+            return buffer;
+        }
+    };
+
+    // Add b[0..bn) to a[0..an) into r, assuming an >= bn, and return the carry out
+    static Limb addLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        return limbKernels().add(r, a, an, b, bn);
+    }
+
+    // Subtract b[0..bn) from a[0..an) into r, assuming an >= bn, and return the borrow out
+    static Limb subLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        return limbKernels().sub(r, a, an, b, bn);
+    }
+
+    // Multiply a[0..n) by m and accumulate into r[0..n), returning the carry limb
+    static Limb mulAddLimbs(Limb *r, const Limb *a, size_t n, Limb m)
+    {
+        return limbKernels().mulAdd(r, a, n, m);
+    }
+
+    // One implementation of each dispatched kernel
+    struct LimbKernelTable
+    {
+        LimbKernel kind;
+        Limb (*add)(Limb *, const Limb *, size_t, const Limb *, size_t);
+        Limb (*sub)(Limb *, const Limb *, size_t, const Limb *, size_t);
+        Limb (*mulAdd)(Limb *, const Limb *, size_t, Limb);
+    };
+
+    static const LimbKernelTable &limbKernels()
+    {
+        static const LimbKernelTable table = selectLimbKernels();
+        return table;
+    }
+
+    static bool limbKernelSupported(LimbKernel kernel)
+    {
+#ifdef BIGNUMBER_X86_KERNELS
+        __builtin_cpu_init();
+        bool adx = __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+        switch (kernel)
+        {
+        case LimbKernel::Adx:
+            return adx;
+        case LimbKernel::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case LimbKernel::Avx512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return true;
+        }
+#else
+        return kernel == LimbKernel::Scalar;
+#endif
+    }
+
+    static LimbKernelTable selectLimbKernels()
+    {
+#ifdef BIGNUMBER_FORCE_KERNEL
+        const LimbKernel kind = static_cast<LimbKernel>(BIGNUMBER_FORCE_KERNEL);
+        if (!limbKernelSupported(kind))
+        {
+            throw std::runtime_error(std::string("Limb kernel not supported by this CPU: ") + limbKernelName(kind));
+        }
+#else
+        LimbKernel kind = LimbKernel::Scalar;
+        for (LimbKernel candidate : {LimbKernel::Adx, LimbKernel::Avx2, LimbKernel::Avx512})
+        {
+            if (limbKernelSupported(candidate))
+            {
+                kind = candidate;
+            }
+        }
+#endif
+        LimbKernelTable table = {kind, addLimbsScalar, subLimbsScalar, mulAddLimbsScalar};
+#ifdef BIGNUMBER_X86_KERNELS
+        // The vector tiers only cover add and subtract; multiply rows use MULX/ADX whenever it exists
+        if (kind != LimbKernel::Scalar)
+        {
+            table.add = addLimbsCarryFlag;
+            table.sub = subLimbsCarryFlag;
+        }
+        if (kind != LimbKernel::Scalar && limbKernelSupported(LimbKernel::Adx))
+        {
+            table.mulAdd = mulAddLimbsAdx;
+        }
+        if (kind == LimbKernel::Avx2)
+        {
+            table.add = addLimbsAvx2;
+            table.sub = subLimbsAvx2;
+        }
+        if (kind == LimbKernel::Avx512)
+        {
+            table.add = addLimbsAvx512;
+            table.sub = subLimbsAvx512;
+        }
+#endif
+        return table;
+    }
+
+    static Limb addLimbsScalar(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        Limb carry = 0;
+        size_t i = 0;
+        for (; i < bn; ++i)
+        {
+            DoubleLimb sum = (DoubleLimb)a[i] + b[i] + carry;
+            r[i] = (Limb)sum;
+            carry = (Limb)(sum >> LIMB_BITS);
+        }
+        for (; i < an; ++i)
+        {
+            Limb sum = a[i] + carry;
+            carry = sum < carry;
+            r[i] = sum;
+        }
+        return carry;
+    }
+
+    static Limb subLimbsScalar(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        Limb borrow = 0;
+        size_t i = 0;
+        for (; i < bn; ++i)
+        {
+            DoubleLimb diff = (DoubleLimb)a[i] - b[i] - borrow;
+            r[i] = (Limb)diff;
+            borrow = (Limb)(diff >> LIMB_BITS) & 1;
+        }
+        for (; i < an; ++i)
+        {
+            Limb diff = a[i] - borrow;
+            borrow = a[i] < borrow;
+            r[i] = diff;
+        }
+        return borrow;
+    }
+
+    static Limb mulAddLimbsScalar(Limb *r, const Limb *a, size_t n, Limb m)
+    {
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            DoubleLimb product = (DoubleLimb)a[i] * m + r[i] + carry;
+            r[i] = (Limb)product;
+            carry = (Limb)(product >> LIMB_BITS);
+        }
+        return carry;
+    }
+
+#ifdef BIGNUMBER_X86_KERNELS
+    // Add with the carry flag threaded through ADC, continuing from limb i with the given carry in. The vector
+    // kernels finish their tails here.
+    static Limb addLimbsCarryFlag(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn, size_t i, Limb carry)
+    {
+        unsigned char flag = (unsigned char)carry;
+        for (; i < bn; ++i)
+        {
+            unsigned long long sum;
+            flag = _addcarry_u64(flag, a[i], b[i], &sum);
+            r[i] = sum;
+        }
+        for (; i < an; ++i)
+        {
+            unsigned long long sum;
+            flag = _addcarry_u64(flag, a[i], 0, &sum);
+            r[i] = sum;
+        }
+        return flag;
+    }
+
+    static Limb addLimbsCarryFlag(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        return addLimbsCarryFlag(r, a, an, b, bn, 0, 0);
+    }
+
+    static Limb subLimbsCarryFlag(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn, size_t i, Limb borrow)
+    {
+        unsigned char flag = (unsigned char)borrow;
+        for (; i < bn; ++i)
+        {
+            unsigned long long diff;
+            flag = _subborrow_u64(flag, a[i], b[i], &diff);
+            r[i] = diff;
+        }
+        for (; i < an; ++i)
+        {
+            unsigned long long diff;
+            flag = _subborrow_u64(flag, a[i], 0, &diff);
+            r[i] = diff;
+        }
+        return flag;
+    }
+
+    static Limb subLimbsCarryFlag(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        return subLimbsCarryFlag(r, a, an, b, bn, 0, 0);
+    }
+
+    // Multiply-accumulate four limbs at a time with two independent carry chains: ADCX carries the high
+    // halves of the products forward and ADOX adds in r, so neither chain waits on the other.
+    static Limb mulAddLimbsAdx(Limb *r, const Limb *a, size_t n, Limb m)
+    {
+        Limb carry = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            Limb low, high, zero;
+            __asm__("xor %k[zero], %k[zero]\n\t"
+                    "mulx 0(%[a]), %[low], %[high]\n\t"
+                    "adcx %[carry], %[low]\n\t"
+                    "adox 0(%[r]), %[low]\n\t"
+                    "mov %[low], 0(%[r])\n\t"
+                    "mulx 8(%[a]), %[low], %[carry]\n\t"
+                    "adcx %[high], %[low]\n\t"
+                    "adox 8(%[r]), %[low]\n\t"
+                    "mov %[low], 8(%[r])\n\t"
+                    "mulx 16(%[a]), %[low], %[high]\n\t"
+                    "adcx %[carry], %[low]\n\t"
+                    "adox 16(%[r]), %[low]\n\t"
+                    "mov %[low], 16(%[r])\n\t"
+                    "mulx 24(%[a]), %[low], %[carry]\n\t"
+                    "adcx %[high], %[low]\n\t"
+                    "adox 24(%[r]), %[low]\n\t"
+                    "mov %[low], 24(%[r])\n\t"
+                    "adcx %[zero], %[carry]\n\t"
+                    "adox %[zero], %[carry]"
+                    : [carry] "+&r"(carry), [low] "=&r"(low), [high] "=&r"(high), [zero] "=&r"(zero)
+                    : [a] "r"(a + i), [r] "r"(r + i), "d"(m)
+                    : "cc", "memory");
+        }
+        for (; i < n; ++i)
+        {
+            DoubleLimb product = (DoubleLimb)a[i] * m + r[i] + carry;
+            r[i] = (Limb)product;
+            carry = (Limb)(product >> LIMB_BITS);
+        }
+        return carry;
+    }
+
+    // Carry lookahead across vector lanes. Bit i of generate says lane i overflowed on its own and bit i of
+    // propagate says it is all ones (all zeros for a subtraction), so it passes an incoming carry along. Adding
+    // propagate to the shifted generate bits ripples every carry through its run of propagating lanes in one
+    // integer add; the result has a bit set for each lane that receives a carry, and one bit past the last
+    // lane for the carry out of the block.
+    static unsigned laneCarries(unsigned generate, unsigned propagate, unsigned carry_in)
+    {
+        return (((generate << 1) | carry_in) + propagate) ^ propagate;
+    }
+
+    __attribute__((target("avx2"))) static Limb addLimbsAvx2(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        // AVX2 has no unsigned 64 bit compare, so flip the sign bits and compare signed
+        const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+        const __m256i all_ones = _mm256_set1_epi64x(-1);
+        const __m256i lane_index = _mm256_set_epi64x(3, 2, 1, 0);
+        const __m256i one = _mm256_set1_epi64x(1);
+        unsigned carry = 0;
+        size_t i = 0;
+        for (; i + 4 <= bn; i += 4)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            __m256i sum = _mm256_add_epi64(x, y);
+            __m256i overflow = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(sum, sign));
+            unsigned generate = _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+            unsigned propagate = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(sum, all_ones)));
+            unsigned carries = laneCarries(generate, propagate, carry);
+            carry = carries >> 4;
+            __m256i increment = _mm256_and_si256(_mm256_srlv_epi64(_mm256_set1_epi64x(carries), lane_index), one);
+            _mm256_storeu_si256((__m256i *)(r + i), _mm256_add_epi64(sum, increment));
+        }
+        return addLimbsCarryFlag(r, a, an, b, bn, i, carry);
+    }
+
+    __attribute__((target("avx2"))) static Limb subLimbsAvx2(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i lane_index = _mm256_set_epi64x(3, 2, 1, 0);
+        const __m256i one = _mm256_set1_epi64x(1);
+        unsigned borrow = 0;
+        size_t i = 0;
+        for (; i + 4 <= bn; i += 4)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+            __m256i diff = _mm256_sub_epi64(x, y);
+            __m256i underflow = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+            unsigned generate = _mm256_movemask_pd(_mm256_castsi256_pd(underflow));
+            unsigned propagate = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(diff, zero)));
+            unsigned borrows = laneCarries(generate, propagate, borrow);
+            borrow = borrows >> 4;
+            __m256i decrement = _mm256_and_si256(_mm256_srlv_epi64(_mm256_set1_epi64x(borrows), lane_index), one);
+            _mm256_storeu_si256((__m256i *)(r + i), _mm256_sub_epi64(diff, decrement));
+        }
+        return subLimbsCarryFlag(r, a, an, b, bn, i, borrow);
+    }
+
+    __attribute__((target("avx512f"))) static Limb addLimbsAvx512(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        const __m512i all_ones = _mm512_set1_epi64(-1);
+        const __m512i one = _mm512_set1_epi64(1);
+        unsigned carry = 0;
+        size_t i = 0;
+        for (; i + 8 <= bn; i += 8)
+        {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i sum = _mm512_add_epi64(x, _mm512_loadu_si512(b + i));
+            unsigned generate = _mm512_cmplt_epu64_mask(sum, x);
+            unsigned propagate = _mm512_cmpeq_epu64_mask(sum, all_ones);
+            unsigned carries = laneCarries(generate, propagate, carry);
+            carry = carries >> 8;
+            _mm512_storeu_si512(r + i, _mm512_mask_add_epi64(sum, (__mmask8)carries, sum, one));
+        }
+        return addLimbsCarryFlag(r, a, an, b, bn, i, carry);
+    }
+
+    __attribute__((target("avx512f"))) static Limb subLimbsAvx512(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i one = _mm512_set1_epi64(1);
+        unsigned borrow = 0;
+        size_t i = 0;
+        for (; i + 8 <= bn; i += 8)
+        {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i diff = _mm512_sub_epi64(x, y);
+            unsigned generate = _mm512_cmplt_epu64_mask(x, y);
+            unsigned propagate = _mm512_cmpeq_epu64_mask(diff, zero);
+            unsigned borrows = laneCarries(generate, propagate, borrow);
+            borrow = borrows >> 8;
+            _mm512_storeu_si512(r + i, _mm512_mask_sub_epi64(diff, (__mmask8)borrows, diff, one));
+        }
+        return subLimbsCarryFlag(r, a, an, b, bn, i, borrow);
+    }
+#endif
+
+    // Divide a[0..n) in place by a single limb and return the remainder
+    static Limb divLimbsBySingle(Limb *a, size_t n, Limb d)
+    {
+        DoubleLimb remainder = 0;
+        for (size_t i = n; i-- > 0;)
+        {
+            DoubleLimb current = (remainder << LIMB_BITS) | a[i];
+            a[i] = (Limb)(current / d);
+            remainder = current % d;
+        }
+        return (Limb)remainder;
+    }
+
+    // Remainder of a[0..n) divided by d < 2^32, taking each limb in two 32 bit halves so that only 64 bit
+    // divisions are needed
+    static Limb modLimbsBySmall(const Limb *a, size_t n, Limb d)
+    {
+        Limb remainder = 0;
+        for (size_t i = n; i-- > 0;)
+        {
+            remainder = ((remainder << 32) | (a[i] >> 32)) % d;
+            remainder = ((remainder << 32) | (a[i] & 0xffffffff)) % d;
+        }
+        return remainder;
+    }
+
+    // Compare the magnitudes of two trimmed limb arrays (-1, 0 or 1)
+    static int compareLimbs(const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        if (an != bn)
+        {
+            return an < bn ? -1 : 1;
+        }
+        for (size_t i = an; i-- > 0;)
+        {
+            if (a[i] != b[i])
+            {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // Multiply a[0..n) by m and subtract it from r[0..n), returning the borrow limb
+    static Limb mulSubLimbs(Limb *r, const Limb *a, size_t n, Limb m)
+    {
+        Limb borrow = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            DoubleLimb product = (DoubleLimb)a[i] * m + borrow;
+            Limb low = (Limb)product;
+            borrow = (Limb)(product >> LIMB_BITS);
+            Limb current = r[i];
+            r[i] = current - low;
+            borrow += current < low;
+        }
+        return borrow;
+    }
+
+    // Shift a[0..n) left by 0 <= shift < 64 bits into r, returning the bits shifted out
+    static Limb shiftLeftLimbs(Limb *r, const Limb *a, size_t n, int shift)
+    {
+        if (shift == 0)
+        {
+            std::copy(a, a + n, r);
+            return 0;
+        }
+        Limb out = a[n - 1] >> (LIMB_BITS - shift);
+        for (size_t i = n - 1; i > 0; --i)
+        {
+            r[i] = (a[i] << shift) | (a[i - 1] >> (LIMB_BITS - shift));
+        }
+        r[0] = a[0] << shift;
+        return out;
+    }
+
+    // Shift a[0..n) right by 0 <= shift < 64 bits into r
+    static void shiftRightLimbs(Limb *r, const Limb *a, size_t n, int shift)
+    {
+        if (shift == 0)
+        {
+            std::copy(a, a + n, r);
+            return;
+        }
+        for (size_t i = 0; i + 1 < n; ++i)
+        {
+            r[i] = (a[i] >> shift) | (a[i + 1] << (LIMB_BITS - shift));
+        }
+        r[n - 1] = a[n - 1] >> shift;
+    }
+
+    // Knuth Algorithm D: divide u[0..un) by v[0..vn), where vn >= 2, un >= vn and v[vn - 1] != 0.
+    // q receives un - vn + 1 limbs (it may be null when only the remainder is wanted), r receives vn limbs
+    // and scratch must hold un + vn + 1 limbs for the normalized operands.
+    static void divmodLimbs(Limb *q, Limb *r, const Limb *u, size_t un, const Limb *v, size_t vn, Limb *scratch)
+    {
+        // Normalize so that the top bit of the divisor is set, which keeps each quotient estimate within 2 of the truth
+        const int shift = __builtin_clzll(v[vn - 1]);
+        Limb *nu = scratch;
+        Limb *nv = scratch + un + 1;
+        shiftLeftLimbs(nv, v, vn, shift);
+        nu[un] = shiftLeftLimbs(nu, u, un, shift);
+
+        const Limb v_top = nv[vn - 1];
+        const Limb v_next = nv[vn - 2];
+
+        for (size_t j = un - vn + 1; j-- > 0;)
+        {
+            // Estimate the quotient limb from the top two limbs of the running remainder
+            DoubleLimb numerator = ((DoubleLimb)nu[j + vn] << LIMB_BITS) | nu[j + vn - 1];
+            DoubleLimb q_hat = numerator / v_top;
+            DoubleLimb r_hat = numerator - q_hat * v_top;
+
+            // Correct the estimate using the next divisor limb
+            while ((q_hat >> LIMB_BITS) != 0 ||
+                   q_hat * v_next > ((r_hat << LIMB_BITS) | nu[j + vn - 2]))
+            {
+                --q_hat;
+                r_hat += v_top;
+                if ((r_hat >> LIMB_BITS) != 0)
+                {
+                    break;
+                }
+            }
+
+            // Multiply and subtract, adding the divisor back in the rare case the estimate was still one too large
+            Limb borrow = mulSubLimbs(nu + j, nv, vn, (Limb)q_hat);
+            Limb top = nu[j + vn];
+            nu[j + vn] = top - borrow;
+            if (top < borrow)
+            {
+                --q_hat;
+                nu[j + vn] += addLimbs(nu + j, nu + j, vn, nv, vn);
+            }
+
+            if (q != nullptr)
+            {
+                q[j] = (Limb)q_hat;
+            }
+        }
+
+        // Undo the normalization on the remainder
+        shiftRightLimbs(r, nu, vn, shift);
+    }
+
+    // Schoolbook product of a[0..an) and b[0..bn) into r[0..an + bn)
+    static void mulSchoolbook(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        std::fill(r, r + an + bn, 0);
+        for (size_t i = 0; i < an; ++i)
+        {
+            r[i + bn] = mulAddLimbs(r + i, b, bn, a[i]);
+        }
+    }
+
+    // Schoolbook square of a[0..n) into r[0..2n), computing each cross product once and doubling it
+    static void sqrSchoolbook(Limb *r, const Limb *a, size_t n)
+    {
+        std::fill(r, r + 2 * n, 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            r[i + n] = mulAddLimbs(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+        shiftLeftLimbs(r, r, 2 * n, 1);
+
+        // Add the squares on the diagonal
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            DoubleLimb square = (DoubleLimb)a[i] * a[i];
+            DoubleLimb low = (DoubleLimb)r[2 * i] + (Limb)square + carry;
+            r[2 * i] = (Limb)low;
+            DoubleLimb high = (DoubleLimb)r[2 * i + 1] + (Limb)(square >> LIMB_BITS) + (Limb)(low >> LIMB_BITS);
+            r[2 * i + 1] = (Limb)high;
+            carry = (Limb)(high >> LIMB_BITS);
+        }
+    }
+
+    // Store |x - y| into r[0..xn), where xn >= yn, and return true when x < y
+    static bool absDiffLimbs(Limb *r, const Limb *x, size_t xn, const Limb *y, size_t yn)
+    {
+        bool x_smaller = false;
+        if (std::all_of(x + yn, x + xn, [](Limb limb) { return limb == 0; }))
+        {
+            size_t i = yn;
+            while (i > 0 && x[i - 1] == y[i - 1])
+            {
+                --i;
+            }
+            x_smaller = i > 0 && x[i - 1] < y[i - 1];
+        }
+
+        if (x_smaller)
+        {
+            subLimbs(r, y, yn, x, yn);
+            std::fill(r + yn, r + xn, 0);
+        }
+        else
+        {
+            subLimbs(r, x, xn, y, yn);
+        }
+        return x_smaller;
+    }
+
+    // Karatsuba product of two n limb operands (or the square of a when b is null) into r[0..2n).
+    // Uses the subtractive form z1 = z0 + z2 - (a1 - a0)(b1 - b0) so that no half ever grows an extra limb.
+    static void karatsubaMultiply(Limb *r, const Limb *a, const Limb *b, size_t n, Limb *scratch)
+    {
+        const size_t h = n / 2;
+        const size_t hh = n - h;
+        Limb *da = scratch;
+        Limb *db = da + hh;
+        Limb *z1 = db + hh;
+        Limb *t = z1 + 2 * hh;
+        Limb *next = t + 2 * hh + 1;
+
+        bool negative_middle = false;
+        if (b == nullptr)
+        {
+            absDiffLimbs(da, a + h, hh, a, h);
+            mulBalanced(r, a, nullptr, h, next);
+            mulBalanced(r + 2 * h, a + h, nullptr, hh, next);
+            mulBalanced(z1, da, nullptr, hh, next);
+        }
+        else
+        {
+            negative_middle = absDiffLimbs(da, a + h, hh, a, h) != absDiffLimbs(db, b + h, hh, b, h);
+            mulBalanced(r, a, b, h, next);
+            mulBalanced(r + 2 * h, a + h, b + h, hh, next);
+            mulBalanced(z1, da, db, hh, next);
+        }
+
+        // t = z0 + z2 -/+ (a1 - a0)(b1 - b0) is the middle coefficient, added in at offset h
+        t[2 * hh] = addLimbs(t, r + 2 * h, 2 * hh, r, 2 * h);
+        if (negative_middle)
+        {
+            addLimbs(t, t, 2 * hh + 1, z1, 2 * hh);
+        }
+        else
+        {
+            subLimbs(t, t, 2 * hh + 1, z1, 2 * hh);
+        }
+        addLimbs(r + h, r + h, n + hh, t, 2 * hh + 1);
+    }
+
+    // Product of two n limb operands (square of a when b is null) into r[0..2n), dispatching on size
+    static void mulBalanced(Limb *r, const Limb *a, const Limb *b, size_t n, Limb *scratch)
+    {
+        const MultiplicationThresholds &thresholds = multiplicationThresholds();
+        if (b == nullptr)
+        {
+            if (n < thresholds.karatsuba_square)
+            {
+                sqrSchoolbook(r, a, n);
+            }
+            else if (n < thresholds.toom3_square)
+            {
+                karatsubaMultiply(r, a, nullptr, n, scratch);
+            }
+            else if (n < thresholds.ntt_square)
+            {
+                toom3Multiply(r, a, nullptr, n);
+            }
+            else
+            {
+                nttMultiply(r, a, n, nullptr, n);
+            }
+        }
+        else if (n < thresholds.karatsuba)
+        {
+            mulSchoolbook(r, a, n, b, n);
+        }
+        else if (n < thresholds.toom3)
+        {
+            karatsubaMultiply(r, a, b, n, scratch);
+        }
+        else if (n < thresholds.ntt)
+        {
+            toom3Multiply(r, a, b, n);
+        }
+        else
+        {
+            nttMultiply(r, a, n, b, n);
+        }
+    }
+
+    // Product of a[0..an) and b[0..bn), an >= bn, into r[0..an + bn); unbalanced operands are cut into bn limb blocks
+    static void mulLimbs(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn, Limb *scratch)
+    {
+        if (bn < multiplicationThresholds().karatsuba)
+        {
+            mulSchoolbook(r, a, an, b, bn);
+            return;
+        }
+        if (bn >= multiplicationThresholds().ntt)
+        {
+            // The transform handles unbalanced operands directly
+            nttMultiply(r, a, an, b, bn);
+            return;
+        }
+        if (an == bn)
+        {
+            mulBalanced(r, a, b, bn, scratch);
+            return;
+        }
+
+        Limb *block = scratch;
+        Limb *next = scratch + 2 * bn;
+        std::fill(r, r + an + bn, 0);
+        for (size_t offset = 0; offset < an; offset += bn)
+        {
+            size_t length = std::min(bn, an - offset);
+            if (length == bn)
+            {
+                mulBalanced(block, a + offset, b, bn, next);
+            }
+            else
+            {
+                mulLimbs(block, b, bn, a + offset, length, next);
+            }
+            addLimbs(r + offset, r + offset, an + bn - offset, block, length + bn);
+        }
+    }
+
+    // Scratch limbs needed by mulLimbs for operands of up to n limbs each
+    static size_t mulScratchSize(size_t n)
+    {
+        return 8 * n + 8 * LIMB_BITS;
+    }
+
+    // Toom-3 product of two n limb operands (square of a when b is null) into r[0..2n).
+    // Evaluates at 0, 1, -1, -2 and infinity and interpolates with Bodrato's sequence; the signed
+    // evaluation and interpolation steps use BigNumber itself since they are linear in the operand size.
+    static void toom3Multiply(Limb *r, const Limb *a, const Limb *b, size_t n)
+    {
+        const size_t k = (n + 2) / 3;
+        const bool square = b == nullptr;
+
+        auto evaluate = [k, n](const Limb *x, BigNumber points[5])
+        {
+            BigNumber x0 = fromLimbs(x, k);
+            BigNumber x1 = fromLimbs(x + k, k);
+            BigNumber x2 = fromLimbs(x + 2 * k, n - 2 * k);
+            BigNumber even = x0 + x2;
+            points[0] = x0;
+            points[1] = even + x1;
+            points[2] = even - x1;
+            points[3] = (points[2] + x2) + (points[2] + x2) - x0;
+            points[4] = x2;
+        };
+
+        BigNumber pa[5], pb[5], w[5];
+        evaluate(a, pa);
+        if (!square)
+        {
+            evaluate(b, pb);
+        }
+        for (int i = 0; i < 5; ++i)
+        {
+            w[i] = square ? pa[i].square() : pa[i] * pb[i];
+        }
+
+        // Interpolate the five coefficients r0..r4 of the product polynomial
+        BigNumber r0 = w[0];
+        BigNumber r4 = w[4];
+        BigNumber r3 = divideBySmallExact(w[3] - w[1], 3);
+        BigNumber r1 = divideBySmallExact(w[1] - w[2], 2);
+        BigNumber r2 = w[2] - w[0];
+        r3 = divideBySmallExact(r2 - r3, 2) + r4 + r4;
+        r2 = r2 + r1 - r4;
+        r1 = r1 - r3;
+
+        // Recompose at x = 2^(64k); every coefficient of a product of non-negative polynomials is non-negative
+        std::fill(r, r + 2 * n, 0);
+        const BigNumber *coefficients[5] = {&r0, &r1, &r2, &r3, &r4};
+        for (size_t i = 0; i < 5; ++i)
+        {
+            const LimbVector &limbs = coefficients[i]->number_limbs;
+            size_t offset = i * k;
+            size_t length = std::min(limbs.size(), 2 * n - offset);
+            addLimbs(r + offset, r + offset, 2 * n - offset, limbs.data(), length);
+        }
+    }
+
+    // Arithmetic modulo a prime p < 2^62 in Montgomery form with R = 2^64, for the number theoretic transform
+    class NttField
+    {
+    public:
+        explicit NttField(Limb modulus)
+            : p(modulus)
+        {
+            // Newton iteration for p^-1 mod 2^64, as in MontgomeryContext
+            p_inverse = p;
+            for (int i = 0; i < 5; ++i)
+            {
+                p_inverse *= 2 - p * p_inverse;
+            }
+            const Limb r = (Limb)((DoubleLimb(1) << LIMB_BITS) % p);
+            r_squared = (Limb)((DoubleLimb)r * r % p);
+            one_value = r;
+        }
+
+        Limb modulus() const
+        {
+            return p;
+        }
+
+        // a * b / R mod p in [0, p), for a * b < p * R
+        Limb multiply(Limb a, Limb b) const
+        {
+            const DoubleLimb t = (DoubleLimb)a * b;
+            const Limb q = (Limb)t * p_inverse;
+            const Limb high = (Limb)(t >> LIMB_BITS);
+            const Limb correction = (Limb)(((DoubleLimb)q * p) >> LIMB_BITS);
+            return high - correction + (p & (0 - (Limb)(high < correction)));
+        }
+
+        // The corrections are masks rather than branches, which the transforms could not predict
+        Limb add(Limb a, Limb b) const
+        {
+            const Limb sum = a + b - p;
+            return sum + (p & (0 - (sum >> (LIMB_BITS - 1))));
+        }
+
+        Limb subtract(Limb a, Limb b) const
+        {
+            return a - b + (p & (0 - (Limb)(a < b)));
+        }
+
+        // Montgomery form x * R mod p of any 64 bit x
+        Limb toMontgomery(Limb x) const
+        {
+            return multiply(x, r_squared);
+        }
+
+        // Montgomery form of 1
+        Limb one() const
+        {
+            return one_value;
+        }
+
+        // base^exponent for base in Montgomery form
+        Limb power(Limb base, Limb exponent) const
+        {
+            Limb result = one_value;
+            for (; exponent != 0; exponent >>= 1)
+            {
+                if ((exponent & 1) != 0)
+                {
+                    result = multiply(result, base);
+                }
+                base = multiply(base, base);
+            }
+            return result;
+        }
+
+    private:
+        Limb p;
+        Limb p_inverse = 0;
+        Limb r_squared = 0;
+        Limb one_value = 0;
+    };
+
+    // The transform primes c * 2^k + 1 with a primitive root g of each; lengths up to 2^54 are supported by all
+    // three, and their product exceeds 2^184, above any convolution term N * 2^128 of 64 bit limbs
+    struct NttPrime
+    {
+        Limb p;
+        Limb generator;
+    };
+    static constexpr NttPrime NTT_PRIMES[3] = {{29 * (Limb(1) << 57) + 1, 3},
+                                               {69 * (Limb(1) << 55) + 1, 5},
+                                               {177 * (Limb(1) << 54) + 1, 7}};
+    static constexpr int NTT_MAX_LOG_LENGTH = 54;
+
+    // twiddles[len + j] = w^j in Montgomery form for each level len = 1, 2, ..., n / 2 and j < len, where w is a
+    // primitive 2 len-th root of unity derived from the primitive n-th root root
+    static void nttTwiddles(const NttField &field, Limb root, size_t n, Limb *twiddles)
+    {
+        const size_t half = n / 2;
+        twiddles[half] = field.one();
+        for (size_t j = 1; j < half; ++j)
+        {
+            twiddles[half + j] = field.multiply(twiddles[half + j - 1], root);
+        }
+        for (size_t len = half / 2; len >= 1; len /= 2)
+        {
+            for (size_t j = 0; j < len; ++j)
+            {
+                twiddles[len + j] = twiddles[2 * len + 2 * j];
+            }
+        }
+    }
+
+    // Decimation in frequency transform of length n, natural order in, bit reversed order out
+    static void nttForward(const NttField &field, Limb *a, size_t n, const Limb *twiddles)
+    {
+        for (size_t len = n / 2; len >= 1; len /= 2)
+        {
+            for (size_t i = 0; i < n; i += 2 * len)
+            {
+                for (size_t j = 0; j < len; ++j)
+                {
+                    const Limb u = a[i + j];
+                    const Limb v = a[i + j + len];
+                    a[i + j] = field.add(u, v);
+                    a[i + j + len] = field.multiply(field.subtract(u, v), twiddles[len + j]);
+                }
+            }
+        }
+    }
+
+    // Decimation in time transform with the inverse twiddles, bit reversed order in, natural order out; the
+    // result is n times the inverse transform
+    static void nttInverse(const NttField &field, Limb *a, size_t n, const Limb *twiddles)
+    {
+        for (size_t len = 1; len < n; len *= 2)
+        {
+            for (size_t i = 0; i < n; i += 2 * len)
+            {
+                for (size_t j = 0; j < len; ++j)
+                {
+                    const Limb u = a[i + j];
+                    const Limb v = field.multiply(a[i + j + len], twiddles[len + j]);
+                    a[i + j] = field.add(u, v);
+                    a[i + j + len] = field.subtract(u, v);
+                }
+            }
+        }
+    }
+
+    // Product of a[0..an) and b[0..bn) (square of a when b is null) into r[0..an + bn) by a number theoretic
+    // transform modulo each of the three NTT_PRIMES, with the limbs as coefficients, and Garner's CRT
+    // recombination of the three cyclic convolutions. Costs O(n log n) limb operations.
+    static void nttMultiply(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        const bool square = b == nullptr;
+        const size_t count = an + bn - 1;
+        size_t n = 2;
+        int log_n = 1;
+        while (n < count)
+        {
+            n <<= 1;
+            ++log_n;
+        }
+        if (log_n > NTT_MAX_LOG_LENGTH)
+        {
+            throw std::length_error("Product too large for the number theoretic transform");
+        }
+
+        ScratchLimbs residues(3 * n), work(square ? 1 : n), twiddles(n), inverse_twiddles(n);
+        for (int k = 0; k < 3; ++k)
+        {
+            const NttField field(NTT_PRIMES[k].p);
+            const Limb p = field.modulus();
+            const Limb root = field.power(field.toMontgomery(NTT_PRIMES[k].generator), (p - 1) >> log_n);
+            nttTwiddles(field, root, n, twiddles.data());
+            nttTwiddles(field, field.power(root, n - 1), n, inverse_twiddles.data());
+
+            Limb *fa = residues.data() + k * n;
+            for (size_t i = 0; i < n; ++i)
+            {
+                fa[i] = i < an ? field.toMontgomery(a[i]) : 0;
+            }
+            nttForward(field, fa, n, twiddles.data());
+            if (square)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    fa[i] = field.multiply(fa[i], fa[i]);
+                }
+            }
+            else
+            {
+                Limb *fb = work.data();
+                for (size_t i = 0; i < n; ++i)
+                {
+                    fb[i] = i < bn ? field.toMontgomery(b[i]) : 0;
+                }
+                nttForward(field, fb, n, twiddles.data());
+                for (size_t i = 0; i < n; ++i)
+                {
+                    fa[i] = field.multiply(fa[i], fb[i]);
+                }
+            }
+            nttInverse(field, fa, n, inverse_twiddles.data());
+
+            // Multiplying by the plain n^-1 = p - (p - 1) / n also leaves the Montgomery domain
+            const Limb n_inverse = p - ((p - 1) >> log_n);
+            for (size_t i = 0; i < count; ++i)
+            {
+                fa[i] = field.multiply(fa[i], n_inverse);
+            }
+        }
+
+        // Garner: x = x1 + p1 x2 + p1 p2 x3 with each xi below pi. The inverses come out of power() in Montgomery
+        // form, so one multiply() applies them to a plain residue.
+        const NttField f2(NTT_PRIMES[1].p), f3(NTT_PRIMES[2].p);
+        const Limb p1 = NTT_PRIMES[0].p;
+        const Limb p2 = NTT_PRIMES[1].p;
+        const Limb p3 = NTT_PRIMES[2].p;
+        const Limb p1_inverse_2 = f2.power(f2.toMontgomery(p1), p2 - 2);
+        const Limb p1_inverse_3 = f3.power(f3.toMontgomery(p1), p3 - 2);
+        const Limb p2_inverse_3 = f3.power(f3.toMontgomery(p2), p3 - 2);
+        const DoubleLimb p12 = (DoubleLimb)p1 * p2;
+
+        const Limb *r1 = residues.data();
+        const Limb *r2 = r1 + n;
+        const Limb *r3 = r2 + n;
+        Limb carry_low = 0;
+        Limb carry_high = 0;
+        for (size_t i = 0; i < an + bn; ++i)
+        {
+            Limb v0 = 0, v1 = 0, v2 = 0;
+            if (i < count)
+            {
+                // p1 < 2 p2 < 2 p3 and p2 < p3, so one conditional subtraction reduces x1, and x2 needs none
+                const Limb x1 = r1[i];
+                const Limb x2 = f2.multiply(f2.subtract(r2[i], x1 - (x1 >= p2 ? p2 : 0)), p1_inverse_2);
+                const Limb x3 = f3.multiply(f3.subtract(f3.multiply(f3.subtract(r3[i], x1 - (x1 >= p3 ? p3 : 0)), p1_inverse_3), x2),
+                                            p2_inverse_3);
+
+                const DoubleLimb low = (DoubleLimb)p1 * x2 + x1;
+                DoubleLimb t = (DoubleLimb)(Limb)p12 * x3 + (Limb)low;
+                v0 = (Limb)t;
+                t = (t >> LIMB_BITS) + (DoubleLimb)(Limb)(p12 >> LIMB_BITS) * x3 + (Limb)(low >> LIMB_BITS);
+                v1 = (Limb)t;
+                v2 = (Limb)(t >> LIMB_BITS);
+            }
+
+            // Add the running carry of the previous coefficients and emit one limb
+            DoubleLimb sum = (DoubleLimb)v0 + carry_low;
+            r[i] = (Limb)sum;
+            sum = (sum >> LIMB_BITS) + v1 + carry_high;
+            carry_low = (Limb)sum;
+            carry_high = v2 + (Limb)(sum >> LIMB_BITS);
+        }
+    }
+
+    // Build a non-negative BigNumber from a raw limb range
+    static BigNumber fromLimbs(const Limb *limbs, size_t n)
+    {
+        BigNumber result;
+        result.number_limbs.assign(limbs, limbs + n);
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Divide by a small value that is known to divide the number exactly, keeping its sign
+    static BigNumber divideBySmallExact(BigNumber value, Limb divisor)
+    {
+        divLimbsBySingle(value.number_limbs.data(), value.number_limbs.size(), divisor);
+        value.trimLeadingZeros();
+        return value;
+    }
+
+public:
+    // Default constructor to initialize BigNumber to zero
+    BigNumber()
+    {
+        number_limbs.push_back(0);
+        isNegative = false;
+    }
+
+    // Constructor from long long
+    BigNumber(long long num)
+    {
+        isNegative = (num < 0);
+        // Negate in unsigned arithmetic so that LLONG_MIN is handled as well
+        Limb magnitude = isNegative ? 0 - (Limb)num : (Limb)num;
+        number_limbs.push_back(magnitude);
+    }
+
+    // Constructor to initialize BigNumber from a string
+    BigNumber(const std::string &number)
+    {
+        number_limbs.push_back(0);
+        if (number.empty())
+        {
+            isNegative = false;
+            return;
+        }
+
+        size_t start = 0; // Start position for reading digits
+
+        // Check for sign
+        if (number[0] == '-')
+        {
+            isNegative = true;
+            start = 1; // Start after the negative sign
+        }
+        else if (number[0] == '+')
+        {
+            start = 1; // Start after the positive sign
+        }
+
+        // Validate up front so that the conversion itself works on plain digit ranges
+        for (size_t i = start; i < number.length(); ++i)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(number[i])))
+            {
+                throw std::invalid_argument("Invalid character in input string");
+            }
+        }
+
+        number_limbs = std::move(parseDecimal(number.data() + start, number.length() - start).number_limbs);
+        trimLeadingZeros();
+    }
+
+    // Byte order for raw import and export
+    enum class ByteOrder
+    {
+        BigEndian,
+        LittleEndian
+    };
+
+    // Build a BigNumber from hexadecimal digits, with an optional sign and 0x prefix
+    static BigNumber fromHex(const std::string &hex)
+    {
+        size_t start = 0;
+        bool negative = false;
+        if (!hex.empty() && (hex[0] == '-' || hex[0] == '+'))
+        {
+            negative = hex[0] == '-';
+            start = 1;
+        }
+        if (hex.compare(start, 2, "0x") == 0 || hex.compare(start, 2, "0X") == 0)
+        {
+            start += 2;
+        }
+
+        // Each digit lands directly in its limb, 16 digits per limb, least significant digit first
+        const size_t count = hex.length() - start;
+        BigNumber result;
+        result.number_limbs.assign(count / 16 + 1, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            char c = hex[hex.length() - 1 - i];
+            Limb digit;
+            if (c >= '0' && c <= '9')
+            {
+                digit = c - '0';
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                digit = c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                digit = c - 'A' + 10;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid character in input string");
+            }
+            result.number_limbs[i / 16] |= digit << (4 * (i % 16));
+        }
+
+        result.isNegative = negative;
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Build a non-negative BigNumber from raw bytes
+    static BigNumber fromBytes(const std::uint8_t *bytes, size_t length, ByteOrder order = ByteOrder::BigEndian)
+    {
+        BigNumber result;
+        result.number_limbs.assign(length / 8 + 1, 0);
+        for (size_t i = 0; i < length; ++i)
+        {
+            // i counts bytes from the least significant end
+            std::uint8_t byte = order == ByteOrder::BigEndian ? bytes[length - 1 - i] : bytes[i];
+            result.number_limbs[i / 8] |= Limb(byte) << (8 * (i % 8));
+        }
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    static BigNumber fromBytes(const std::vector<std::uint8_t> &bytes, ByteOrder order = ByteOrder::BigEndian)
+    {
+        return fromBytes(bytes.data(), bytes.size(), order);
+    }
+
+    // Whether the value is 0, checked on the limbs without building a comparison temporary
+    bool isZero() const
+    {
+        return number_limbs.size() == 1 && number_limbs[0] == 0;
+    }
+
+    // Whether the value is +1
+    bool isOne() const
+    {
+        return number_limbs.size() == 1 && number_limbs[0] == 1 && !isNegative;
+    }
+
+    // Number of significant bits in the magnitude (0 for zero)
+    size_t bitLength() const
+    {
+        Limb top = number_limbs.back();
+        if (top == 0)
+        {
+            return 0;
+        }
+        return (number_limbs.size() - 1) * LIMB_BITS + (LIMB_BITS - __builtin_clzll(top));
+    }
+
+    // Value of bit i of the magnitude
+    bool testBit(size_t i) const
+    {
+        size_t limb = i / LIMB_BITS;
+        return limb < number_limbs.size() && ((number_limbs[limb] >> (i % LIMB_BITS)) & 1) != 0;
+    }
+
+    // Remove leading zeros from the number
+    void trimLeadingZeros()
+    {
+        while (number_limbs.size() > 1 && number_limbs.back() == 0)
+        {
+            number_limbs.pop_back();
+        }
+        if (number_limbs.empty())
+        {
+            number_limbs.push_back(0);
+        }
+        if (isZero())
+        {
+            isNegative = false; // Zero is non-negative
+        }
+    }
+
+    // absoulte value of the number
+    BigNumber absolute() const
+    {
+        BigNumber result = *this;
+        result.isNegative = false;
+        return result;
+    }
+
+    // Convert the number to string
+    std::string to_string() const
+    {
+        // If the BigNum represents zero, return "0"
+        if (isZero())
+        {
+            return "0";
+        }
+
+        std::string result;
+
+        // Add negative sign if the number is negative
+        if (isNegative)
+        {
+            result += '-';
+        }
+
+        formatDecimal(*this, 0, result);
+        return result;
+    }
+
+    // Convert the number to a lower case hexadecimal string without prefix
+    std::string to_hex() const
+    {
+        if (isZero())
+        {
+            return "0";
+        }
+
+        static const char digits[] = "0123456789abcdef";
+        std::string result;
+        result.reserve(number_limbs.size() * 16 + 1);
+        if (isNegative)
+        {
+            result += '-';
+        }
+
+        // The top limb is printed without leading zeros, every other limb as exactly 16 digits
+        Limb top = number_limbs.back();
+        int shift = (LIMB_BITS - 1 - __builtin_clzll(top)) / 4 * 4;
+        for (; shift >= 0; shift -= 4)
+        {
+            result += digits[(top >> shift) & 15];
+        }
+        for (size_t i = number_limbs.size() - 1; i-- > 0;)
+        {
+            for (shift = LIMB_BITS - 4; shift >= 0; shift -= 4)
+            {
+                result += digits[(number_limbs[i] >> shift) & 15];
+            }
+        }
+        return result;
+    }
+
+    // Export the magnitude as raw bytes; the minimal encoding (one byte for zero) when length is 0,
+    // otherwise zero padded to exactly length bytes
+    std::vector<std::uint8_t> toBytes(ByteOrder order = ByteOrder::BigEndian, size_t length = 0) const
+    {
+        const size_t needed = std::max<size_t>((bitLength() + 7) / 8, 1);
+        if (length != 0 && needed > length && bitLength() > 0)
+        {
+            throw std::out_of_range("Value does not fit in the requested number of bytes");
+        }
+        const size_t size = length != 0 ? length : needed;
+
+        std::vector<std::uint8_t> bytes(size, 0);
+        for (size_t i = 0; i < std::min(needed, size); ++i)
+        {
+            std::uint8_t byte = (number_limbs[i / 8] >> (8 * (i % 8))) & 0xff;
+            bytes[order == ByteOrder::BigEndian ? size - 1 - i : i] = byte;
+        }
+        return bytes;
+    }
+
+private:
+    // Decimal conversion switches from the quadratic chunk loop to divide and conquer above these sizes
+    static constexpr size_t DECIMAL_SPLIT_DIGITS = 16000;
+    static constexpr size_t DECIMAL_SPLIT_LIMBS = 30;
+
+    // 10^(19 * 2^level), cached per thread; a deque keeps references stable as the cache grows
+    static const BigNumber &decimalPower(size_t level)
+    {
+        thread_local std::deque<BigNumber> powers;
+        if (powers.size() > level)
+        {
+            return powers[level];
+        }
+
+        // The cache outlives any scoped resource, so like the scratch pool it always fills from the heap
+        LimbResourceScope heap(std::pmr::new_delete_resource());
+        if (powers.empty())
+        {
+            powers.push_back(fromLimbs(&DECIMAL_CHUNK, 1));
+        }
+        while (powers.size() <= level)
+        {
+            powers.push_back(powers.back().square());
+        }
+        return powers[level];
+    }
+
+    // Value of a run of validated decimal digits. Long runs are split so the low part has 19 * 2^level digits,
+    // and the halves are recombined as high * 10^(19 * 2^level) + low, which costs O(M(n) log n)
+    static BigNumber parseDecimal(const char *digits, size_t count)
+    {
+        if (count > DECIMAL_SPLIT_DIGITS)
+        {
+            size_t level = 0;
+            while ((size_t(DECIMAL_CHUNK_DIGITS) << (level + 1)) <= count / 2)
+            {
+                ++level;
+            }
+            const size_t low_digits = size_t(DECIMAL_CHUNK_DIGITS) << level;
+
+            BigNumber result = parseDecimal(digits, count - low_digits);
+            result *= decimalPower(level);
+            result += parseDecimal(digits + count - low_digits, low_digits);
+            return result;
+        }
+
+        // Consume the digits in chunks of up to 19, scaling the accumulated value each time
+        BigNumber result;
+        result.number_limbs.reserve(count / DECIMAL_CHUNK_DIGITS + 2);
+        size_t i = 0;
+        while (i < count)
+        {
+            size_t chunk_end = std::min(count, i + DECIMAL_CHUNK_DIGITS);
+            Limb chunk = 0;
+            Limb scale = 1;
+            for (; i < chunk_end; ++i)
+            {
+                chunk = chunk * 10 + (digits[i] - '0');
+                scale *= 10;
+            }
+
+            Limb carry = chunk;
+            for (Limb &limb : result.number_limbs)
+            {
+                DoubleLimb product = (DoubleLimb)limb * scale + carry;
+                limb = (Limb)product;
+                carry = (Limb)(product >> LIMB_BITS);
+            }
+            if (carry != 0)
+            {
+                result.number_limbs.push_back(carry);
+            }
+        }
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Append the decimal digits of |value|, zero padded on the left to at least pad digits. Large values are split
+    // by the cached power of ten closest to their square root and both halves are converted recursively.
+    static void formatDecimal(const BigNumber &value, size_t pad, std::string &out)
+    {
+        const size_t n = value.number_limbs.size();
+        if (n > DECIMAL_SPLIT_LIMBS)
+        {
+            size_t level = 0;
+            while (decimalPower(level + 1).number_limbs.size() * 2 <= n)
+            {
+                ++level;
+            }
+            const size_t low_digits = size_t(DECIMAL_CHUNK_DIGITS) << level;
+
+            BigNumber quotient, remainder;
+            if (decimalPower(level).number_limbs.size() >= NEWTON_DIVISION_LIMBS)
+            {
+                newtonDivide(value, decimalDivisor(level), quotient, remainder);
+            }
+            else
+            {
+                value.divideMagnitudes(decimalPower(level), &quotient, &remainder);
+            }
+            formatDecimal(quotient, pad > low_digits ? pad - low_digits : 0, out);
+            formatDecimal(remainder, low_digits, out);
+            return;
+        }
+
+        // Peel off base 10^19 chunks, least significant first
+        ScratchLimbs work(n), chunks(2 * n + 1);
+        std::copy(value.number_limbs.begin(), value.number_limbs.end(), work.data());
+        size_t used = n;
+        while (used > 0 && work.data()[used - 1] == 0)
+        {
+            --used;
+        }
+        size_t chunk_count = 0;
+        while (used > 0)
+        {
+            chunks.data()[chunk_count++] = divLimbsBySingle(work.data(), used, DECIMAL_CHUNK);
+            while (used > 0 && work.data()[used - 1] == 0)
+            {
+                --used;
+            }
+        }
+
+        if (chunk_count == 0)
+        {
+            out.append(std::max<size_t>(pad, 1), '0');
+            return;
+        }
+
+        // The leading chunk is printed as is, every other chunk is zero padded to 19 digits
+        const size_t lower_digits = (chunk_count - 1) * DECIMAL_CHUNK_DIGITS;
+        appendChunk(out, chunks.data()[chunk_count - 1], pad > lower_digits ? pad - lower_digits : 0);
+        for (size_t i = chunk_count - 1; i-- > 0;)
+        {
+            appendChunk(out, chunks.data()[i], DECIMAL_CHUNK_DIGITS);
+        }
+    }
+
+    // Append one base 10^19 chunk, zero padded on the left to at least width digits
+    static void appendChunk(std::string &out, Limb chunk, size_t width)
+    {
+        char digits[DECIMAL_CHUNK_DIGITS];
+        size_t count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        } while (chunk != 0);
+
+        out.append(width > count ? width - count : 0, '0');
+        while (count > 0)
+        {
+            out += digits[--count];
+        }
+    }
+
+public:
+
+    // overloading == operator
+    bool operator==(const BigNumber &other_number) const
+    {
+        return number_limbs == other_number.number_limbs && isNegative == other_number.isNegative;
+    }
+
+    // overloading != operator
+    bool operator!=(const BigNumber &other_number) const
+    {
+        return !(*this == other_number);
+    }
+
+    // overloading < operator
+    bool operator<(const BigNumber &other_number) const
+    {
+        if (isNegative != other_number.isNegative)
+        {
+            return isNegative;
+        }
+
+        int cmp = compareLimbs(number_limbs.data(), number_limbs.size(),
+                               other_number.number_limbs.data(), other_number.number_limbs.size());
+        return isNegative ? cmp > 0 : cmp < 0;
+    }
+
+    // overloading > operator
+    bool operator>(const BigNumber &other_number) const
+    {
+        return other_number < *this;
+    }
+
+    // overloading <= operator
+    bool operator<=(const BigNumber &other_number) const
+    {
+        return !(*this > other_number);
+    }
+
+    // overloading >= operator
+    bool operator>=(const BigNumber &other_number) const
+    {
+        return !(*this < other_number);
+    }
+
+    // Helper function to add absolute values of two BigNumbers
+    BigNumber addAbsoluteValues(const BigNumber &a, const BigNumber &b) const
+    {
+        const BigNumber &longer = a.number_limbs.size() >= b.number_limbs.size() ? a : b;
+        const BigNumber &shorter = &longer == &a ? b : a;
+
+        BigNumber result;
+        result.isNegative = false;
+        result.number_limbs.resize(longer.number_limbs.size() + 1);
+
+        Limb carry = addLimbs(result.number_limbs.data(),
+                              longer.number_limbs.data(), longer.number_limbs.size(),
+                              shorter.number_limbs.data(), shorter.number_limbs.size());
+        result.number_limbs.back() = carry;
+
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Helper function to subtract absolute values of two BigNumbers (a - b) assuming |a| >= |b|
+    BigNumber subtractAbsoluteValues(const BigNumber &a, const BigNumber &b) const
+    {
+        BigNumber result;
+        result.isNegative = false;
+        result.number_limbs.resize(a.number_limbs.size());
+
+        subLimbs(result.number_limbs.data(),
+                 a.number_limbs.data(), a.number_limbs.size(),
+                 b.number_limbs.data(), b.number_limbs.size());
+
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Compare the absolute values of two numbers (-1, 0 or 1) without copying either
+    int compareAbsolute(const BigNumber &other_number) const
+    {
+        return compareLimbs(number_limbs.data(), number_limbs.size(),
+                            other_number.number_limbs.data(), other_number.number_limbs.size());
+    }
+
+    // Overload the += operator, adding in place and reusing this number's storage
+    BigNumber &operator+=(const BigNumber &other_number)
+    {
+        OperationProbe probe(Operation::Add, std::max(number_limbs.size(), other_number.number_limbs.size()));
+        addSigned(other_number, other_number.isNegative);
+        return *this;
+    }
+
+    // Overload the -= operator, subtracting in place without copying other_number
+    BigNumber &operator-=(const BigNumber &other_number)
+    {
+        OperationProbe probe(Operation::Subtract, std::max(number_limbs.size(), other_number.number_limbs.size()));
+        addSigned(other_number, !other_number.isNegative);
+        return *this;
+    }
+
+    // Overload the *= operator; the product is built in scratch space and copied back into this number's storage
+    BigNumber &operator*=(const BigNumber &other_number)
+    {
+        assignProduct(*this, other_number);
+        return *this;
+    }
+
+    // Overload the %= operator, leaving the remainder in this number's storage
+    BigNumber &operator%=(const BigNumber &other_number)
+    {
+        divideMagnitudes(other_number, nullptr, this);
+        return *this;
+    }
+
+    // Overload the /= operator, leaving the quotient in this number's storage
+    BigNumber &operator/=(const BigNumber &other_number)
+    {
+        divideMagnitudes(other_number, this, nullptr);
+        return *this;
+    }
+
+    // Wrap an operand so that +, -, * and % build a lazy expression instead of computing each intermediate.
+    // The expression holds references to its operands and is evaluated when assigned to a BigNumber.
+    static LazyExpression<LazyOperand> lazy(const BigNumber &value);
+
+    // Evaluate a lazy expression into this number, reusing its storage; the expression may refer to this number
+    template <typename Node>
+    BigNumber &operator=(const LazyExpression<Node> &expression)
+    {
+        expression.evaluate(*this);
+        return *this;
+    }
+
+    // Overload the + operator for BigNumber
+    BigNumber operator+(const BigNumber &other_number) const &
+    {
+        BigNumber result;
+        result.number_limbs.reserve(std::max(number_limbs.size(), other_number.number_limbs.size()) + 1);
+        result.number_limbs = number_limbs;
+        result.isNegative = isNegative;
+        result += other_number;
+        return result;
+    }
+
+    // Rvalue overloads of + reuse the storage of whichever operand is a temporary
+    BigNumber operator+(const BigNumber &other_number) &&
+    {
+        *this += other_number;
+        return std::move(*this);
+    }
+
+    BigNumber operator+(BigNumber &&other_number) const &
+    {
+        other_number += *this;
+        return std::move(other_number);
+    }
+
+    BigNumber operator+(BigNumber &&other_number) &&
+    {
+        *this += other_number;
+        return std::move(*this);
+    }
+
+    // Overload the - operator for BigNumber
+    BigNumber operator-(const BigNumber &other_number) const &
+    {
+        BigNumber result;
+        result.number_limbs.reserve(std::max(number_limbs.size(), other_number.number_limbs.size()) + 1);
+        result.number_limbs = number_limbs;
+        result.isNegative = isNegative;
+        result -= other_number;
+        return result;
+    }
+
+    // Rvalue overloads of - reuse the storage of whichever operand is a temporary
+    BigNumber operator-(const BigNumber &other_number) &&
+    {
+        *this -= other_number;
+        return std::move(*this);
+    }
+
+    BigNumber operator-(BigNumber &&other_number) const &
+    {
+        // a - b = -(b - a)
+        other_number -= *this;
+        other_number.negate();
+        return std::move(other_number);
+    }
+
+    BigNumber operator-(BigNumber &&other_number) &&
+    {
+        *this -= other_number;
+        return std::move(*this);
+    }
+
+    // Overload the * operator for BigNumber
+    BigNumber operator*(const BigNumber &other_number) const &
+    {
+        BigNumber result;
+        result.assignProduct(*this, other_number);
+        return result;
+    }
+
+    // Rvalue overload of * reuses the storage of the temporary for the product
+    BigNumber operator*(const BigNumber &other_number) &&
+    {
+        *this *= other_number;
+        return std::move(*this);
+    }
+
+    // Square of the number
+    BigNumber square() const
+    {
+        BigNumber result;
+        result.assignProduct(*this, *this);
+        return result;
+    }
+
+    // Overload the % operator for BigNumber (modulus operation)
+    BigNumber operator%(const BigNumber &other_number) const &
+    {
+        // Only the remainder is needed, so skip building the quotient
+        return modulo(other_number);
+    }
+
+    // Rvalue overload of % leaves the remainder in the temporary's storage
+    BigNumber operator%(const BigNumber &other_number) &&
+    {
+        *this %= other_number;
+        return std::move(*this);
+    }
+
+    // Overload the / operator for BigNumber
+    BigNumber operator/(const BigNumber &other_number) const
+    {
+        BigNumber result;
+        divideMagnitudes(other_number, &result, nullptr);
+        return result;
+    }
+
+    // Helper function to divide two BigNumbers
+    std::pair<BigNumber, BigNumber> divide(const BigNumber &other_number) const
+    {
+        BigNumber result, remainder;
+        divideMagnitudes(other_number, &result, &remainder);
+        return {std::move(result), std::move(remainder)};
+    }
+
+    // Remainder of the division (sign follows the dividend), without computing the quotient
+    BigNumber modulo(const BigNumber &other_number) const
+    {
+        BigNumber remainder;
+        divideMagnitudes(other_number, nullptr, &remainder);
+        return remainder;
+    }
+
+private:
+    // this += (negate ? -|other| : |other|), in place; other_number may alias this
+    void addSigned(const BigNumber &other_number, bool negate)
+    {
+        const size_t an = number_limbs.size();
+        const size_t bn = other_number.number_limbs.size();
+
+        if (isNegative == negate)
+        {
+            // Same sign: add the magnitudes, growing by at most one limb
+            number_limbs.resize(std::max(an, bn) + 1, 0);
+            const Limb *b = other_number.number_limbs.data();
+            if (an >= bn)
+            {
+                number_limbs.back() = addLimbs(number_limbs.data(), number_limbs.data(), an, b, bn);
+            }
+            else
+            {
+                number_limbs.back() = addLimbs(number_limbs.data(), b, bn, number_limbs.data(), an);
+            }
+        }
+        else if (compareLimbs(number_limbs.data(), an, other_number.number_limbs.data(), bn) >= 0)
+        {
+            // Different signs and |this| >= |other|: the sign of this survives
+            subLimbs(number_limbs.data(), number_limbs.data(), an, other_number.number_limbs.data(), bn);
+        }
+        else
+        {
+            // Different signs and |this| < |other|: the result is |other| - |this| with the sign of other
+            number_limbs.resize(bn, 0);
+            subLimbs(number_limbs.data(), other_number.number_limbs.data(), bn, number_limbs.data(), bn);
+            isNegative = negate;
+        }
+
+        trimLeadingZeros();
+    }
+
+    // Flip the sign in place, keeping zero non-negative
+    void negate()
+    {
+        isNegative = !isNegative;
+        trimLeadingZeros();
+    }
+
+    // this = a * b; the product goes through pooled scratch so a and b may alias this
+    void assignProduct(const BigNumber &a, const BigNumber &b)
+    {
+        OperationProbe probe(Operation::Multiply, std::max(a.number_limbs.size(), b.number_limbs.size()));
+        const bool negative = a.isNegative != b.isNegative; // The sign of the result is negative if the signs are different
+
+        // Multiplying a number by itself takes the cheaper squaring path
+        if (&a == &b || a.number_limbs == b.number_limbs)
+        {
+            const size_t n = a.number_limbs.size();
+            ScratchLimbs product(2 * n), scratch(mulScratchSize(n));
+            mulBalanced(product.data(), a.number_limbs.data(), nullptr, n, scratch.data());
+            number_limbs.assign(product.data(), product.data() + 2 * n);
+        }
+        else
+        {
+            const BigNumber &longer = a.number_limbs.size() >= b.number_limbs.size() ? a : b;
+            const BigNumber &shorter = &longer == &a ? b : a;
+            const size_t an = longer.number_limbs.size();
+            const size_t bn = shorter.number_limbs.size();
+
+            ScratchLimbs product(an + bn), scratch(mulScratchSize(an)); // Room for the full double width product
+            mulLimbs(product.data(), longer.number_limbs.data(), an, shorter.number_limbs.data(), bn, scratch.data());
+            number_limbs.assign(product.data(), product.data() + an + bn);
+        }
+
+        isNegative = negative;
+        trimLeadingZeros();
+    }
+
+    // Division switches from Knuth's algorithm D to Newton reciprocal division once the divisor and the quotient
+    // both have this many limbs
+    static constexpr size_t NEWTON_DIVISION_LIMBS = 256;
+
+    // A divisor normalized and paired with its reciprocal for Newton division; defined after the class
+    struct NewtonDivisor;
+
+    // decimalPower(level) prepared for Newton division, cached per thread like the powers themselves
+    static const NewtonDivisor &decimalDivisor(size_t level);
+
+    // Prepare |divisor| for newtonDivide
+    static NewtonDivisor newtonDivisor(const BigNumber &divisor);
+
+    // floor(B^(2k) / divisor) for a k limb divisor with its top bit set, where B = 2^64
+    static BigNumber newtonReciprocal(const BigNumber &divisor);
+
+    // |dividend| / divisor and |dividend| % divisor, both non-negative
+    static void newtonDivide(const BigNumber &dividend, const NewtonDivisor &divisor, BigNumber &quotient,
+                             BigNumber &remainder);
+
+    // The same with a divisor prepared on the spot
+    static void newtonDivide(const BigNumber &dividend, const BigNumber &divisor, BigNumber &quotient,
+                             BigNumber &remainder);
+
+    // value * B^count
+    static BigNumber shiftLimbs(const BigNumber &value, size_t count)
+    {
+        BigNumber result;
+        result.number_limbs.assign(count + value.number_limbs.size(), 0);
+        std::copy(value.number_limbs.begin(), value.number_limbs.end(), result.number_limbs.data() + count);
+        result.isNegative = value.isNegative;
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // floor(|value| / B^count) with the sign of value
+    static BigNumber dropLimbs(const BigNumber &value, size_t count)
+    {
+        if (count >= value.number_limbs.size())
+        {
+            return BigNumber();
+        }
+        BigNumber result = fromLimbs(value.number_limbs.data() + count, value.number_limbs.size() - count);
+        result.isNegative = value.isNegative;
+        result.trimLeadingZeros();
+        return result;
+    }
+
+    // Truncating division shared by the division operators; either output may be null when it is not needed
+    // and either may alias this or other_number, since they are only written once the division is done
+    void divideMagnitudes(const BigNumber &other_number, BigNumber *quotient, BigNumber *remainder) const
+    {
+        OperationProbe probe(Operation::Divide, number_limbs.size());
+        if (other_number.isZero())
+        {
+            countDivisionByZero();
+            // throw std::invalid_argument("Division by zero");
+            std::cout << "Does not exist" << std::endl;
+            if (quotient != nullptr)
+            {
+                *quotient = BigNumber();
+            }
+            if (remainder != nullptr)
+            {
+                *remainder = BigNumber();
+            }
+            return;
+        }
+
+        const size_t un = number_limbs.size();
+        const size_t vn = other_number.number_limbs.size();
+        const bool dividend_negative = isNegative;
+        const bool quotient_negative = isNegative != other_number.isNegative;
+
+        // A dividend smaller than the divisor is its own remainder
+        if (compareLimbs(number_limbs.data(), un, other_number.number_limbs.data(), vn) < 0)
+        {
+            if (remainder != nullptr && remainder != this)
+            {
+                *remainder = *this;
+            }
+            if (quotient != nullptr)
+            {
+                quotient->number_limbs.assign(1, 0);
+                quotient->isNegative = false;
+            }
+            return;
+        }
+
+        const size_t qn = un - vn + 1;
+        if (vn >= NEWTON_DIVISION_LIMBS && qn >= NEWTON_DIVISION_LIMBS)
+        {
+            BigNumber quotient_value, remainder_value;
+            newtonDivide(*this, other_number, quotient_value, remainder_value);
+            if (remainder != nullptr)
+            {
+                *remainder = std::move(remainder_value);
+                remainder->isNegative = dividend_negative;
+                remainder->trimLeadingZeros();
+            }
+            if (quotient != nullptr)
+            {
+                *quotient = std::move(quotient_value);
+                quotient->isNegative = quotient_negative;
+                quotient->trimLeadingZeros();
+            }
+            return;
+        }
+
+        ScratchLimbs quotient_limbs(un), remainder_limbs(vn);
+
+        if (vn == 1)
+        {
+            // Short division by a single limb
+            std::copy(number_limbs.begin(), number_limbs.end(), quotient_limbs.data());
+            remainder_limbs.data()[0] = divLimbsBySingle(quotient_limbs.data(), un, other_number.number_limbs[0]);
+        }
+        else
+        {
+            ScratchLimbs scratch(un + vn + 1);
+            divmodLimbs(quotient != nullptr ? quotient_limbs.data() : nullptr, remainder_limbs.data(),
+                        number_limbs.data(), un, other_number.number_limbs.data(), vn, scratch.data());
+        }
+
+        if (remainder != nullptr)
+        {
+            remainder->number_limbs.assign(remainder_limbs.data(), remainder_limbs.data() + vn);
+            remainder->isNegative = dividend_negative;
+            remainder->trimLeadingZeros();
+        }
+        if (quotient != nullptr)
+        {
+            quotient->number_limbs.assign(quotient_limbs.data(), quotient_limbs.data() + qn);
+            quotient->isNegative = quotient_negative;
+            quotient->trimLeadingZeros();
+        }
+    }
+
+public:
+
+    // Overload the unary - operator for BigNumber
+    BigNumber operator-() const &
+    {
+        BigNumber result = *this;
+        result.negate();
+        return result;
+    }
+
+    // Rvalue overload of unary - flips the sign of the temporary in place
+    BigNumber operator-() &&
+    {
+        negate();
+        return std::move(*this);
+    }
+
+    // function for modalar addition
+    BigNumber modAddition(const BigNumber &other_number, const BigNumber &modulus)
+    {
+        BigNumber result = *this + other_number;
+        reduceModulo(result, modulus);
+        return result;
+    }
+
+    // fuction for modular multiplication
+    BigNumber modMultiplication(const BigNumber &other_number, const BigNumber &modulus)
+    {
+        BigNumber result = *this * other_number;
+        reduceModulo(result, modulus);
+        return result;
+    }
+
+    // modular addition into a caller provided result, reusing its storage; result may alias either operand
+    void modAddition(const BigNumber &other_number, const BigNumber &modulus, BigNumber &result) const
+    {
+        if (&result == &other_number)
+        {
+            result += *this;
+        }
+        else
+        {
+            result = *this;
+            result += other_number;
+        }
+        reduceModulo(result, modulus);
+    }
+
+    // modular multiplication into a caller provided result, reusing its storage; result may alias either operand
+    void modMultiplication(const BigNumber &other_number, const BigNumber &modulus, BigNumber &result) const
+    {
+        result.assignProduct(*this, other_number);
+        reduceModulo(result, modulus);
+    }
+
+    // modular addition reusing a precomputed reducer
+    BigNumber modAddition(const BigNumber &other_number, const Reducer &reducer) const;
+
+    // modular multiplication reusing a precomputed reducer
+    BigNumber modMultiplication(const BigNumber &other_number, const Reducer &reducer) const;
+
+    // modular multiplication reusing a precomputed context for an odd modulus
+    BigNumber modMultiplication(const BigNumber &other_number, const MontgomeryContext &context) const;
+
+    // modular exponentiation, result in [0, modulus); odd moduli run in the Montgomery domain
+    BigNumber modPow(const BigNumber &exponent, const BigNumber &modulus) const;
+
+    // modular exponentiation reusing a precomputed context for an odd modulus
+    BigNumber modPow(const BigNumber &exponent, const MontgomeryContext &context) const;
+
+    // Product of bases[i]^exponents[i] mod modulus in [0, modulus), with one squaring chain shared by all terms
+    static BigNumber multiModPow(const std::vector<BigNumber> &bases, const std::vector<BigNumber> &exponents,
+                                 const BigNumber &modulus);
+
+private:
+    // value %= modulus in place, taking the mask or fold fast path for power of two and pseudo-Mersenne moduli
+    static void reduceModulo(BigNumber &value, const BigNumber &modulus);
+
+    // Left to right sliding window exponentiation over any representation of the residues.
+    // multiply(r, a, b) stores a * b in r and must allow r to alias a or b.
+    template <typename Element, typename Multiply>
+    static Element windowedPow(const BigNumber &exponent, const Element &base, const Element &one, Multiply multiply)
+    {
+        const size_t bits = exponent.bitLength();
+        if (bits == 0)
+        {
+            return one;
+        }
+        const size_t window = bits <= 24 ? 1 : bits <= 80 ? 3 : bits <= 240 ? 4 : bits <= 672 ? 5 : 6;
+
+        // Odd powers base^1, base^3, ..., base^(2^window - 1)
+        std::vector<Element> table(size_t(1) << (window - 1), base);
+        if (table.size() > 1)
+        {
+            Element base_squared = base;
+            multiply(base_squared, base, base);
+            for (size_t k = 1; k < table.size(); ++k)
+            {
+                multiply(table[k], table[k - 1], base_squared);
+            }
+        }
+
+        Element result = one;
+        bool started = false;
+        size_t i = bits; // Bits above i have been consumed
+        while (i > 0)
+        {
+            if (!exponent.testBit(i - 1))
+            {
+                if (started)
+                {
+                    multiply(result, result, result);
+                }
+                --i;
+                continue;
+            }
+
+            // Take the longest window of at most window bits starting here and ending in a set bit
+            size_t low = i > window ? i - window : 0;
+            while (!exponent.testBit(low))
+            {
+                ++low;
+            }
+            size_t value = 0;
+            for (size_t k = i; k-- > low;)
+            {
+                value = (value << 1) | (exponent.testBit(k) ? 1 : 0);
+            }
+
+            if (started)
+            {
+                for (size_t k = low; k < i; ++k)
+                {
+                    multiply(result, result, result);
+                }
+                multiply(result, result, table[value >> 1]);
+            }
+            else
+            {
+                result = table[value >> 1];
+                started = true;
+            }
+            i = low;
+        }
+        return result;
+    }
+
+    // Product of bases[i]^exponents[i] over any representation of the residues, squaring once per exponent bit
+    // for all terms together. Each pass consumes one window of every exponent. Straus keeps a table of powers per
+    // base and multiplies in one entry per term; Pippenger drops each base into the bucket of its window digit and
+    // folds the buckets together with two products each, which wins once there are many terms. Whichever needs
+    // fewer multiplications is used.
+    template <typename Element, typename Multiply>
+    static Element multiPow(const std::vector<BigNumber> &exponents, const std::vector<Element> &bases,
+                            const Element &one, Multiply multiply)
+    {
+        const size_t terms = bases.size();
+        size_t bits = 0;
+        for (const BigNumber &exponent : exponents)
+        {
+            bits = std::max(bits, exponent.bitLength());
+        }
+        if (bits == 0)
+        {
+            return one;
+        }
+
+        // Multiplications on top of the shared squarings for a window of w bits
+        size_t straus_window = 1;
+        size_t pippenger_window = 1;
+        size_t straus_cost = std::numeric_limits<size_t>::max();
+        size_t pippenger_cost = std::numeric_limits<size_t>::max();
+        for (size_t w = 1; w <= MAX_MULTI_POW_WINDOW; ++w)
+        {
+            const size_t windows = (bits + w - 1) / w;
+            const size_t straus = terms * ((size_t(1) << w) - 2) + windows * terms;
+            const size_t pippenger = windows * (terms + (size_t(2) << w));
+            if (straus < straus_cost && w <= MAX_STRAUS_WINDOW)
+            {
+                straus_cost = straus;
+                straus_window = w;
+            }
+            if (pippenger < pippenger_cost)
+            {
+                pippenger_cost = pippenger;
+                pippenger_window = w;
+            }
+        }
+
+        const size_t window = straus_cost <= pippenger_cost ? straus_window : pippenger_window;
+        const size_t entries = size_t(1) << window;
+        Element result = one;
+        bool started = false;
+        auto multiplyInto = [&multiply](Element &target, bool &set, const Element &factor)
+        {
+            if (set)
+            {
+                multiply(target, target, factor);
+            }
+            else
+            {
+                target = factor;
+                set = true;
+            }
+        };
+
+        if (straus_cost <= pippenger_cost)
+        {
+            // table[i * entries + j] = bases[i]^j for j in [1, entries)
+            std::vector<Element> table(terms * entries, one);
+            for (size_t i = 0; i < terms; ++i)
+            {
+                Element *powers = table.data() + i * entries;
+                powers[1] = bases[i];
+                for (size_t j = 2; j < entries; ++j)
+                {
+                    multiply(powers[j], powers[j - 1], bases[i]);
+                }
+            }
+
+            for (size_t w = (bits + window - 1) / window; w-- > 0;)
+            {
+                for (size_t k = 0; started && k < window; ++k)
+                {
+                    multiply(result, result, result);
+                }
+                for (size_t i = 0; i < terms; ++i)
+                {
+                    const size_t digit = windowDigit(exponents[i], w * window, window);
+                    if (digit != 0)
+                    {
+                        multiplyInto(result, started, table[i * entries + digit]);
+                    }
+                }
+            }
+            return result;
+        }
+
+        std::vector<Element> buckets(entries, one);
+        std::vector<char> filled(entries);
+        Element running = one;
+        Element sum = one;
+        for (size_t w = (bits + window - 1) / window; w-- > 0;)
+        {
+            for (size_t k = 0; started && k < window; ++k)
+            {
+                multiply(result, result, result);
+            }
+
+            std::fill(filled.begin(), filled.end(), 0);
+            for (size_t i = 0; i < terms; ++i)
+            {
+                const size_t digit = windowDigit(exponents[i], w * window, window);
+                if (digit != 0)
+                {
+                    bool set = filled[digit] != 0;
+                    multiplyInto(buckets[digit], set, bases[i]);
+                    filled[digit] = 1;
+                }
+            }
+
+            // Product of bucket[j]^j: running holds the product of the buckets from the top down to j, and
+            // multiplying it into sum at every j counts bucket j exactly j times
+            bool running_set = false;
+            bool sum_set = false;
+            for (size_t j = entries - 1; j > 0; --j)
+            {
+                if (filled[j] != 0)
+                {
+                    multiplyInto(running, running_set, buckets[j]);
+                }
+                if (running_set)
+                {
+                    multiplyInto(sum, sum_set, running);
+                }
+            }
+            if (sum_set)
+            {
+                multiplyInto(result, started, sum);
+            }
+        }
+        return result;
+    }
+
+    // Bits [low, low + width) of the magnitude, for width below 64
+    static size_t windowDigit(const BigNumber &value, size_t low, size_t width)
+    {
+        const size_t limb = low / LIMB_BITS;
+        const size_t offset = low % LIMB_BITS;
+        if (limb >= value.number_limbs.size())
+        {
+            return 0;
+        }
+        Limb digit = value.number_limbs[limb] >> offset;
+        if (offset + width > LIMB_BITS && limb + 1 < value.number_limbs.size())
+        {
+            digit |= value.number_limbs[limb + 1] << (LIMB_BITS - offset);
+        }
+        return digit & ((Limb(1) << width) - 1);
+    }
+
+    // Window limits for multiPow: Straus stores 2^w powers of every base, Pippenger 2^w buckets in total
+    static constexpr size_t MAX_STRAUS_WINDOW = 8;
+    static constexpr size_t MAX_MULTI_POW_WINDOW = 16;
+
+    // Primes below SIEVE_BOUND sieve the candidates of generatePrime; isProbablePrime trial divides by the
+    // first TRIAL_DIVISION_PRIMES of them (the primes below 1024)
+    static constexpr uint32_t SIEVE_BOUND = 1 << 16;
+    static constexpr size_t TRIAL_DIVISION_PRIMES = 171;
+
+    // Odd candidates per sieved interval of generatePrime
+    static constexpr size_t SIEVE_INTERVAL = 4096;
+
+    // The odd primes below SIEVE_BOUND, by a sieve of Eratosthenes run once
+    static const std::vector<uint32_t> &smallPrimes()
+    {
+        static const std::vector<uint32_t> primes = []
+        {
+            std::vector<char> composite(SIEVE_BOUND);
+            std::vector<uint32_t> found;
+            for (uint32_t i = 3; i < SIEVE_BOUND; i += 2)
+            {
+                if (composite[i] != 0)
+                {
+                    continue;
+                }
+                found.push_back(i);
+                for (uint32_t j = i * i; j < SIEVE_BOUND; j += 2 * i)
+                {
+                    composite[j] = 1;
+                }
+            }
+            return found;
+        }();
+        return primes;
+    }
+
+    // |value| mod each of the first count small primes. Primes are taken in groups whose product stays below
+    // 2^32, so each group costs one pass over the limbs.
+    static void smallPrimeResidues(const BigNumber &value, size_t count, uint32_t *residues)
+    {
+        const std::vector<uint32_t> &primes = smallPrimes();
+        size_t begin = 0;
+        while (begin < count)
+        {
+            Limb product = primes[begin];
+            size_t end = begin + 1;
+            while (end < count && product * primes[end] < (Limb(1) << 32))
+            {
+                product *= primes[end++];
+            }
+            const Limb remainder = modLimbsBySmall(value.number_limbs.data(), value.number_limbs.size(), product);
+            for (size_t i = begin; i < end; ++i)
+            {
+                residues[i] = (uint32_t)(remainder % primes[i]);
+            }
+            begin = end;
+        }
+    }
+
+    // One Miller-Rabin round of the odd modulus of context with the given witness
+    static bool millerRabinRound(const MontgomeryContext &context, const BigNumber &witness);
+
+    // Uniform witness in [2, n - 2] for n >= 5; witnesses need no cryptographic quality
+    static BigNumber randomWitness(const BigNumber &n)
+    {
+        thread_local std::mt19937_64 generator(std::random_device{}());
+        BigNumber value;
+        value.number_limbs.resize(n.number_limbs.size() + 1);
+        for (Limb &limb : value.number_limbs)
+        {
+            limb = generator();
+        }
+        return value % (n - BigNumber(3)) + BigNumber(2);
+    }
+
+    // Random odd number of exactly bits bits with the top two bits set
+    static BigNumber randomCandidate(size_t bits, std::random_device &entropy)
+    {
+        BigNumber value;
+        value.number_limbs.resize((bits + LIMB_BITS - 1) / LIMB_BITS);
+        for (Limb &limb : value.number_limbs)
+        {
+            limb = (Limb(entropy()) << 32) | entropy();
+        }
+        if (bits % LIMB_BITS != 0)
+        {
+            value.number_limbs.back() &= (Limb(1) << (bits % LIMB_BITS)) - 1;
+        }
+        value.number_limbs[0] |= 1;
+        value.number_limbs[(bits - 1) / LIMB_BITS] |= Limb(1) << ((bits - 1) % LIMB_BITS);
+        value.number_limbs[(bits - 2) / LIMB_BITS] |= Limb(1) << ((bits - 2) % LIMB_BITS);
+        return value;
+    }
+
+    // Shared search behind both generatePrime overloads; executor may be null
+    static BigNumber searchPrime(size_t bits, BatchExecutor *executor, int rounds);
+
+public:
+
+    // Modular inverse in [0, modulus); throws std::invalid_argument when gcd(this, modulus) != 1
+    BigNumber modInverse(const BigNumber &modulus) const
+    {
+        OperationProbe probe(Operation::ModInverse, modulus.number_limbs.size());
+        BigNumber m = modulus.absolute();
+        if (m.isZero())
+        {
+            throw std::invalid_argument("Modular inverse does not exist");
+        }
+        if (m.isOne())
+        {
+            return 0;
+        }
+
+        BigNumber a = *this % m;
+        if (a.isNegative)
+        {
+            a = a + m;
+        }
+
+        if ((m.number_limbs[0] & 1) != 0)
+        {
+            return binaryInverse(a, m);
+        }
+
+        // For an even modulus only odd values can be invertible. Invert the modulus modulo a instead
+        // (a is odd, so the binary algorithm applies), since m * y = 1 + k * a gives a * (m - k) = 1 mod m.
+        if ((a.number_limbs[0] & 1) == 0)
+        {
+            throw std::invalid_argument("Modular inverse does not exist");
+        }
+        if (a.isOne())
+        {
+            return a;
+        }
+        BigNumber y = binaryInverse(m % a, a);
+        return m - (m * y - BigNumber(1)) / a;
+    }
+
+    // Replace every element by its inverse modulo modulus, sharing a single inversion across the batch
+    static size_t batchModInverse(std::vector<BigNumber> &values, const BigNumber &modulus);
+
+    // out[i] = a[i].modMultiplication(b[i], modulus) for i in [0, n). out may be the same array as a or b.
+    static void batchModMul(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n, const BigNumber &modulus);
+
+    // Whether the number is prime. Below 2^32 trial division decides exactly; above, trial division by the
+    // small primes is followed by rounds Miller-Rabin rounds, base 2 and then random bases, which a composite
+    // passes with probability at most 4^-rounds.
+    bool isProbablePrime(int rounds = 40) const;
+
+    // Random prime of exactly bits bits (at least 2) with its top two bits set, so that the product of two such
+    // primes has 2 * bits bits. Starting points come from std::random_device. Candidates are taken in order from
+    // an interval that is sieved by all odd primes below 2^16 at once, and must pass rounds Miller-Rabin rounds.
+    static BigNumber generatePrime(size_t bits, int rounds = 40);
+
+    // As above, with the Miller-Rabin tests of the sieve survivors and the rounds of the final candidate spread
+    // over the executor's workers. Returns the same prime the sequential search would for the same interval.
+    static BigNumber generatePrime(size_t bits, BatchExecutor &executor, int rounds = 40);
+
+private:
+    // Binary extended GCD (Stein) inversion of a modulo an odd m, working in place on limbs with shifts,
+    // subtractions and halvings modulo m. Maintains u = x1 * a and v = x2 * a (mod m) throughout.
+    static BigNumber binaryInverse(const BigNumber &a, const BigNumber &m)
+    {
+        const size_t n = m.number_limbs.size();
+        const Limb *modulus = m.number_limbs.data();
+
+        // u, v and the cofactors x1, x2 share one scratch loan of n limbs each
+        ScratchLimbs scratch(4 * n);
+        Limb *u = scratch.data(), *v = u + n, *x1 = v + n, *x2 = x1 + n;
+        std::fill(u, u + 4 * n, 0);
+        std::copy(a.number_limbs.begin(), a.number_limbs.end(), u);
+        std::copy(m.number_limbs.begin(), m.number_limbs.end(), v);
+        x1[0] = 1;
+        size_t un = a.number_limbs.size(), vn = n;
+
+        // Strip the trailing zero bits of a value and halve its cofactor modulo m once per bit
+        auto strip_twos = [n, modulus](Limb *value, size_t &used, Limb *cofactor)
+        {
+            size_t zero_limbs = 0;
+            while (value[zero_limbs] == 0)
+            {
+                ++zero_limbs;
+            }
+            int zero_bits = __builtin_ctzll(value[zero_limbs]);
+            size_t shift = zero_limbs * LIMB_BITS + zero_bits;
+            if (shift == 0)
+            {
+                return;
+            }
+
+            std::copy(value + zero_limbs, value + used, value);
+            used -= zero_limbs;
+            shiftRightLimbs(value, value, used, zero_bits);
+            if (used > 1 && value[used - 1] == 0)
+            {
+                --used;
+            }
+
+            for (size_t i = 0; i < shift; ++i)
+            {
+                Limb carry = (cofactor[0] & 1) != 0 ? addLimbs(cofactor, cofactor, n, modulus, n) : 0;
+                shiftRightLimbs(cofactor, cofactor, n, 1);
+                cofactor[n - 1] |= carry << (LIMB_BITS - 1);
+            }
+        };
+        auto is_one = [](const Limb *value, size_t used) { return used == 1 && value[0] == 1; };
+        auto is_zero = [](const Limb *value, size_t used) { return used == 1 && value[0] == 0; };
+
+        while (!is_zero(u, un) && !is_zero(v, vn))
+        {
+            strip_twos(u, un, x1);
+            strip_twos(v, vn, x2);
+            if (is_one(u, un))
+            {
+                return fromLimbs(x1, n);
+            }
+            if (is_one(v, vn))
+            {
+                return fromLimbs(x2, n);
+            }
+
+            // Subtract the smaller value from the larger one, and its cofactor modulo m
+            if (compareLimbs(u, un, v, vn) >= 0)
+            {
+                subLimbs(u, u, un, v, vn);
+                while (un > 1 && u[un - 1] == 0)
+                {
+                    --un;
+                }
+                if (subLimbs(x1, x1, n, x2, n) != 0)
+                {
+                    addLimbs(x1, x1, n, modulus, n);
+                }
+            }
+            else
+            {
+                subLimbs(v, v, vn, u, un);
+                while (vn > 1 && v[vn - 1] == 0)
+                {
+                    --vn;
+                }
+                if (subLimbs(x2, x2, n, x1, n) != 0)
+                {
+                    addLimbs(x2, x2, n, modulus, n);
+                }
+            }
+        }
+
+        // One of the values reached zero before either reached one, so the gcd is the other one and exceeds 1
+        throw std::invalid_argument("Modular inverse does not exist");
+    }
+
+public:
+};
+
+// A divisor shifted left until its top bit is set, with the shift and floor(B^(2k) / divisor) for its k limbs
+struct BigNumber::NewtonDivisor
+{
+    BigNumber divisor;
+    int shift = 0;
+    BigNumber reciprocal;
+};
+
+inline BigNumber::NewtonDivisor BigNumber::newtonDivisor(const BigNumber &divisor)
+{
+    const size_t k = divisor.number_limbs.size();
+    NewtonDivisor prepared;
+    prepared.shift = __builtin_clzll(divisor.number_limbs.back());
+    prepared.divisor.number_limbs.resize(k);
+    shiftLeftLimbs(prepared.divisor.number_limbs.data(), divisor.number_limbs.data(), k, prepared.shift);
+    prepared.reciprocal = newtonReciprocal(prepared.divisor);
+    return prepared;
+}
+
+// The reciprocal of the top h > k / 2 limbs, scaled by B^(k - h), is within a factor 1 +- 3 B^-h of the answer.
+// One Newton step x += x (B^(2k) - d x) / B^(2k) squares that error, leaving x off by at most a few units,
+// which the remainder B^(2k) - d x corrects. Each level costs a few multiplications of its size, so the whole
+// recursion costs O(M(k)).
+inline BigNumber BigNumber::newtonReciprocal(const BigNumber &divisor)
+{
+    const size_t k = divisor.number_limbs.size();
+    BigNumber power;
+    power.number_limbs.assign(2 * k + 1, 0);
+    power.number_limbs.back() = 1;
+    if (k < NEWTON_DIVISION_LIMBS)
+    {
+        BigNumber reciprocal;
+        power.divideMagnitudes(divisor, &reciprocal, nullptr);
+        return reciprocal;
+    }
+
+    const size_t h = k / 2 + 1;
+    const BigNumber top_reciprocal = newtonReciprocal(fromLimbs(divisor.number_limbs.data() + (k - h), h));
+
+    // error = B^(2k) - d x0 with x0 = top_reciprocal B^(k - h); the products skip the k - h zero limbs of x0
+    BigNumber error = power - shiftLimbs(divisor * top_reciprocal, k - h);
+    BigNumber step = dropLimbs(top_reciprocal * error, k + h);
+
+    BigNumber reciprocal = shiftLimbs(top_reciprocal, k - h);
+    reciprocal += step;
+    BigNumber remainder = error - divisor * step;
+    while (remainder.isNegative)
+    {
+        remainder += divisor;
+        reciprocal -= BigNumber(1);
+    }
+    while (remainder >= divisor)
+    {
+        remainder -= divisor;
+        reciprocal += BigNumber(1);
+    }
+    return reciprocal;
+}
+
+// Long division in blocks of k limbs, the divisor's size: each step divides the running remainder followed by the
+// next block by the divisor with a Barrett estimate from the reciprocal, which is at most two below the true
+// quotient block.
+inline void BigNumber::newtonDivide(const BigNumber &dividend, const NewtonDivisor &divisor, BigNumber &quotient,
+                                    BigNumber &remainder)
+{
+    const BigNumber &v = divisor.divisor;
+    const size_t k = v.number_limbs.size();
+    const size_t un = dividend.number_limbs.size() + 1;
+
+    LimbVector u(un);
+    u[un - 1] = shiftLeftLimbs(u.data(), dividend.number_limbs.data(), un - 1, divisor.shift);
+
+    // The leading part keeps at most k limbs, so it is below 2 v
+    const size_t blocks = un > k ? (un - 1) / k : 0;
+    BigNumber current = fromLimbs(u.data() + blocks * k, un - blocks * k);
+    quotient.number_limbs.assign(blocks * k + 1, 0);
+    quotient.isNegative = false;
+    if (current >= v)
+    {
+        current -= v;
+        quotient.number_limbs[blocks * k] = 1;
+    }
+
+    for (size_t j = blocks; j-- > 0;)
+    {
+        // x = current B^k + block j, below v B^k
+        BigNumber x;
+        x.number_limbs.assign(u.data() + j * k, u.data() + (j + 1) * k);
+        x.number_limbs.resize(k + current.number_limbs.size());
+        std::copy(current.number_limbs.begin(), current.number_limbs.end(), x.number_limbs.data() + k);
+        x.trimLeadingZeros();
+
+        BigNumber block = dropLimbs(dropLimbs(x, k - 1) * divisor.reciprocal, k + 1);
+        current = x - block * v;
+        while (current >= v)
+        {
+            current -= v;
+            block += BigNumber(1);
+        }
+        std::copy(block.number_limbs.begin(), block.number_limbs.end(), quotient.number_limbs.data() + j * k);
+    }
+    quotient.trimLeadingZeros();
+
+    // Undo the normalization on the remainder
+    remainder = std::move(current);
+    shiftRightLimbs(remainder.number_limbs.data(), remainder.number_limbs.data(), remainder.number_limbs.size(),
+                    divisor.shift);
+    remainder.trimLeadingZeros();
+}
+
+inline void BigNumber::newtonDivide(const BigNumber &dividend, const BigNumber &divisor, BigNumber &quotient,
+                                    BigNumber &remainder)
+{
+    newtonDivide(dividend, newtonDivisor(divisor), quotient, remainder);
+}
+
+inline const BigNumber::NewtonDivisor &BigNumber::decimalDivisor(size_t level)
+{
+    thread_local std::deque<NewtonDivisor> divisors;
+    if (divisors.size() > level)
+    {
+        return divisors[level];
+    }
+
+    // Filled from the heap like decimalPower(), since the cache outlives any scoped resource
+    LimbResourceScope heap(std::pmr::new_delete_resource());
+    while (divisors.size() <= level)
+    {
+        divisors.push_back(newtonDivisor(decimalPower(divisors.size())));
+    }
+    return divisors[level];
+}
+
+// Precomputed state for Montgomery multiplication modulo a fixed odd modulus m of n limbs.
+// Values in Montgomery form are x * R mod m with R = 2^(64n); multiply() maps aR, bR to abR
+// using only multiplications and shifts, so repeated products against the same modulus never divide.
+class MontgomeryContext
+{
+public:
+    using Limb = BigNumber::Limb;
+    using DoubleLimb = BigNumber::DoubleLimb;
+    using LimbVector = BigNumber::LimbVector;
+
+    explicit MontgomeryContext(const BigNumber &modulus)
+        : modulus_value(modulus), modulus_limbs(modulus.number_limbs)
+    {
+        if (modulus.isNegative || (modulus_limbs[0] & 1) == 0 || modulus.isOne())
+        {
+            throw std::invalid_argument("Montgomery modulus must be odd and greater than one");
+        }
+
+        // Newton iteration for m^-1 mod 2^64; m is its own inverse mod 8 and each step doubles the correct bits
+        Limb inverse = modulus_limbs[0];
+        for (int i = 0; i < 5; ++i)
+        {
+            inverse *= 2 - modulus_limbs[0] * inverse;
+        }
+        m_inverse = 0 - inverse;
+
+        // R^2 mod m converts into Montgomery form with a single multiply()
+        const size_t n = modulus_limbs.size();
+        BigNumber r_squared;
+        r_squared.number_limbs.assign(2 * n + 1, 0);
+        r_squared.number_limbs[2 * n] = 1;
+        r_squared_limbs = padded(r_squared % modulus_value);
+    }
+
+    // The modulus this context reduces by
+    const BigNumber &modulus() const
+    {
+        return modulus_value;
+    }
+
+    // Number of limbs n in the modulus and in every Montgomery form operand
+    size_t size() const
+    {
+        return modulus_limbs.size();
+    }
+
+    // -m^-1 mod 2^64
+    Limb inverse() const
+    {
+        return m_inverse;
+    }
+
+    // |value| reduced into [0, m)
+    BigNumber reduce(const BigNumber &value) const
+    {
+        BigNumber magnitude = value.absolute();
+        if (magnitude >= modulus_value)
+        {
+            magnitude = magnitude % modulus_value;
+        }
+        return magnitude;
+    }
+
+    // Convert x into Montgomery form x * R mod m, reducing x first when it is outside [0, m)
+    BigNumber toMontgomery(const BigNumber &value) const
+    {
+        return fromLimbs(multiplyLimbs(padded(reduce(value)), r_squared_limbs));
+    }
+
+    // Convert x * R mod m back to x
+    BigNumber fromMontgomery(const BigNumber &value) const
+    {
+        LimbVector one(size(), 0);
+        one[0] = 1;
+        return fromLimbs(multiplyLimbs(padded(value), one));
+    }
+
+    // Montgomery form of one, i.e. R mod m
+    BigNumber one() const
+    {
+        LimbVector one(size(), 0);
+        one[0] = 1;
+        return fromLimbs(multiplyLimbs(one, r_squared_limbs));
+    }
+
+    // Montgomery product a * b * R^-1 mod m of two values already in Montgomery form
+    BigNumber multiply(const BigNumber &a, const BigNumber &b) const
+    {
+        return fromLimbs(multiplyLimbs(padded(a), padded(b)));
+    }
+
+    // Limbs of a value in [0, m), zero extended to n limbs
+    LimbVector padded(const BigNumber &value) const
+    {
+        LimbVector limbs = value.number_limbs;
+        limbs.resize(size(), 0);
+        return limbs;
+    }
+
+    // Limb level Montgomery product for hot loops: a, b and r hold n limbs each (r may alias a or b)
+    // and scratch must hold 2n + 2 limbs. Uses the coarsely integrated operand scanning (CIOS) method, with
+    // both passes of each step running through the multiply-accumulate kernel.
+    void multiplyLimbs(Limb *r, const Limb *a, const Limb *b, Limb *scratch) const
+    {
+        const size_t n = size();
+        const Limb *m = modulus_limbs.data();
+        std::fill(scratch, scratch + 2 * n + 2, 0);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            // Instead of shifting t down a limb after each step, slide the window t over the scratch buffer
+            Limb *t = scratch + i;
+
+            // t += a[i] * b
+            Limb carry = BigNumber::mulAddLimbs(t, b, n, a[i]);
+            DoubleLimb top = (DoubleLimb)t[n] + carry;
+            t[n] = (Limb)top;
+            t[n + 1] = (Limb)(top >> BigNumber::LIMB_BITS);
+
+            // t += q * m, with q chosen so that the low limb cancels
+            Limb q = t[0] * m_inverse;
+            carry = BigNumber::mulAddLimbs(t, m, n, q);
+            top = (DoubleLimb)t[n] + carry;
+            t[n] = (Limb)top;
+            t[n + 1] += (Limb)(top >> BigNumber::LIMB_BITS);
+        }
+
+        // The result t is below 2m, so subtracting m once brings it into [0, m). The subtraction always runs,
+        // into the low limbs the window has left behind, and a mask picks t or t - m without a branch:
+        // t[n] - borrow is zero exactly when t >= m and all ones otherwise.
+        Limb *t = scratch + n;
+        const Limb keep = t[n] - BigNumber::subLimbs(scratch, t, n, m, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            r[i] = (t[i] & keep) | (scratch[i] & ~keep);
+        }
+    }
+
+    // a * b mod m for a and b in [0, m) in plain form: the Montgomery product abR^-1 followed by a product with
+    // R^2, so the reduction happens inside both multiplication loops. Same buffers as multiplyLimbs.
+    void multiplyModuloLimbs(Limb *r, const Limb *a, const Limb *b, Limb *scratch) const
+    {
+        multiplyLimbs(r, a, b, scratch);
+        multiplyLimbs(r, r, r_squared_limbs.data(), scratch);
+    }
+
+    // base^exponent mod m for a secret exponent below 2^(64n). Unlike BigNumber::modPow(), which slides its window
+    // over the set bits, the sequence of products does not depend on the exponent: every one of the 16n windows
+    // of FIXED_WINDOW_BITS costs the same squarings and one table product, zero windows included, and each table
+    // lookup reads all entries and keeps one by mask.
+    BigNumber fixedWindowPower(const BigNumber &base, const BigNumber &exponent) const
+    {
+        const size_t n = size();
+        if (exponent.isNegative || exponent.number_limbs.size() > n)
+        {
+            throw std::invalid_argument("Exponent out of range");
+        }
+        const size_t entries = size_t(1) << FIXED_WINDOW_BITS;
+        BigNumber::ScratchLimbs scratch((entries + 2) * n + 2 * n + 2);
+        Limb *table = scratch.data();
+        Limb *x = table + entries * n;
+        Limb *entry = x + n;
+        Limb *acc = entry + n;
+
+        // table[i] = base^i * R mod m
+        const LimbVector one = padded(this->one());
+        const LimbVector base_limbs = padded(toMontgomery(base));
+        const LimbVector exponent_limbs = padded(exponent);
+        std::copy(one.begin(), one.end(), table);
+        std::copy(base_limbs.begin(), base_limbs.end(), table + n);
+        for (size_t i = 2; i < entries; ++i)
+        {
+            multiplyLimbs(table + i * n, table + (i - 1) * n, table + n, acc);
+        }
+
+        std::copy(one.begin(), one.end(), x);
+        for (size_t w = n * BigNumber::LIMB_BITS / FIXED_WINDOW_BITS; w-- > 0;)
+        {
+            for (int k = 0; k < FIXED_WINDOW_BITS; ++k)
+            {
+                multiplyLimbs(x, x, x, acc);
+            }
+            const size_t bit = w * FIXED_WINDOW_BITS;
+            const Limb value = (exponent_limbs[bit / BigNumber::LIMB_BITS] >> (bit % BigNumber::LIMB_BITS)) &
+                               (entries - 1);
+            std::fill(entry, entry + n, 0);
+            for (size_t i = 0; i < entries; ++i)
+            {
+                const Limb mask = 0 - (Limb)(i == value);
+                for (size_t j = 0; j < n; ++j)
+                {
+                    entry[j] |= table[i * n + j] & mask;
+                }
+            }
+            multiplyLimbs(x, x, entry, acc);
+        }
+        return fromMontgomery(BigNumber::fromLimbs(x, n));
+    }
+
+private:
+    // The window must divide the limb size so that no window straddles two limbs
+    static constexpr int FIXED_WINDOW_BITS = 4;
+
+    BigNumber modulus_value;
+    LimbVector modulus_limbs;
+    LimbVector r_squared_limbs;
+    Limb m_inverse = 0;
+
+    LimbVector multiplyLimbs(const LimbVector &a, const LimbVector &b) const
+    {
+        LimbVector result(size());
+        BigNumber::ScratchLimbs scratch(2 * size() + 2);
+        multiplyLimbs(result.data(), a.data(), b.data(), scratch.data());
+        return result;
+    }
+
+    static BigNumber fromLimbs(const LimbVector &limbs)
+    {
+        return BigNumber::fromLimbs(limbs.data(), limbs.size());
+    }
+};
+
+// Montgomery multiplication of LANES independent operand pairs at once, one pair per 64 bit lane of an AVX-512
+// register. Operands are split into d digits of 52 bits and stored struct-of-arrays, digit j of every lane side
+// by side, so a single IFMA instruction (VPMADD52LUQ/VPMADD52HUQ) forms one digit product for all lanes. The
+// modulus is shared and broadcast to every lane. R = 2^(52d).
+class MontgomeryLanes
+{
+public:
+    using Limb = BigNumber::Limb;
+    using LimbVector = BigNumber::LimbVector;
+
+    static constexpr size_t LANES = 8;
+    static constexpr int DIGIT_BITS = 52;
+    static constexpr Limb DIGIT_MASK = (Limb(1) << DIGIT_BITS) - 1;
+
+    // Each accumulator digit collects up to 4d + 2 partial products below 2^52 and must not overflow 64 bits
+    static constexpr size_t MAX_DIGITS = 512;
+
+    // Whether the lane engine can run here for a modulus of the given size: the AVX-512 limb kernels must be
+    // active and the CPU must support IFMA
+    static bool available(const BigNumber &modulus)
+    {
+#ifdef BIGNUMBER_X86_KERNELS
+        return BigNumber::limbKernel() == BigNumber::LimbKernel::Avx512 && __builtin_cpu_supports("avx512ifma") &&
+               digitCount(modulus.bitLength()) <= MAX_DIGITS;
+#else
+        (void)modulus;
+        return false;
+#endif
+    }
+
+    explicit MontgomeryLanes(const MontgomeryContext &context)
+        : digits(digitCount(context.modulus().bitLength())), m_inverse(context.inverse() & DIGIT_MASK)
+    {
+        const BigNumber &modulus = context.modulus();
+
+        // R^2 mod m takes a product out of the Montgomery domain: (ab / R) * R^2 / R = ab
+        BigNumber r_squared;
+        r_squared.number_limbs.assign(2 * DIGIT_BITS * digits / BigNumber::LIMB_BITS + 1, 0);
+        r_squared.number_limbs.back() = Limb(1) << (2 * DIGIT_BITS * digits % BigNumber::LIMB_BITS);
+        r_squared = r_squared % modulus;
+
+        modulus_digits.assign(digits * LANES, 0);
+        r_squared_digits.assign(digits * LANES, 0);
+        for (size_t lane = 0; lane < LANES; ++lane)
+        {
+            toDigits(modulus, modulus_digits.data() + lane);
+            toDigits(r_squared, r_squared_digits.data() + lane);
+        }
+    }
+
+    // Number of 52 bit digits per operand
+    size_t size() const
+    {
+        return digits;
+    }
+
+    // Split value, which must lie in [0, 2^(52d)), into the digits of one lane of a struct-of-arrays buffer
+    void toDigits(const BigNumber &value, Limb *lane_digits) const
+    {
+        const LimbVector &limbs = value.number_limbs;
+        for (size_t j = 0; j < digits; ++j)
+        {
+            size_t bit = j * DIGIT_BITS;
+            size_t limb = bit / BigNumber::LIMB_BITS;
+            int offset = bit % BigNumber::LIMB_BITS;
+            Limb digit = limb < limbs.size() ? limbs[limb] >> offset : 0;
+            if (offset > BigNumber::LIMB_BITS - DIGIT_BITS && limb + 1 < limbs.size())
+            {
+                digit |= limbs[limb + 1] << (BigNumber::LIMB_BITS - offset);
+            }
+            lane_digits[j * LANES] = digit & DIGIT_MASK;
+        }
+    }
+
+    // Reassemble one lane of a struct-of-arrays buffer into value, reusing its storage
+    void fromDigits(const Limb *lane_digits, BigNumber &value) const
+    {
+        LimbVector &limbs = value.number_limbs;
+        limbs.assign((digits * DIGIT_BITS + BigNumber::LIMB_BITS - 1) / BigNumber::LIMB_BITS, 0);
+        for (size_t j = 0; j < digits; ++j)
+        {
+            size_t bit = j * DIGIT_BITS;
+            size_t limb = bit / BigNumber::LIMB_BITS;
+            int offset = bit % BigNumber::LIMB_BITS;
+            Limb digit = lane_digits[j * LANES];
+            limbs[limb] |= digit << offset;
+            if (offset > BigNumber::LIMB_BITS - DIGIT_BITS)
+            {
+                limbs[limb + 1] |= digit >> (BigNumber::LIMB_BITS - offset);
+            }
+        }
+        value.isNegative = false;
+        value.trimLeadingZeros();
+    }
+
+    // Lane wise a * b mod m for operands in [0, m): a Montgomery product followed by one with R^2. a, b and r
+    // hold d digits per lane and r may alias a or b.
+    void multiplyModulo(const Limb *a, const Limb *b, Limb *r) const
+    {
+        BigNumber::ScratchLimbs scratch(accumulatorSize() + digits * LANES);
+        Limb *product = scratch.data() + accumulatorSize();
+        multiply(a, b, product, scratch.data());
+        multiply(product, r_squared_digits.data(), r, scratch.data());
+    }
+
+    // Lane wise base^exponent mod m for bases in [0, m), with one exponent shared by every lane. A fixed window
+    // multiplies by a table entry after every WINDOW_BITS squarings, zero windows included, so all lanes follow
+    // the same sequence of products. The window count covers at least the modulus size and each lookup reads the
+    // whole table, so a secret exponent below m shows neither in the timing nor in the addresses touched.
+    // base and r may alias.
+    void power(const Limb *base, const BigNumber &exponent, Limb *r) const
+    {
+        const size_t width = digits * LANES;
+        const size_t entries = size_t(1) << WINDOW_BITS;
+        BigNumber::ScratchLimbs scratch(accumulatorSize() + (entries + 3) * width);
+        Limb *acc = scratch.data();
+        Limb *table = acc + accumulatorSize();
+        Limb *one = table + entries * width;
+        Limb *x = one + width;
+        Limb *entry = x + width;
+
+        // table[i] = base^i * R mod m, starting from R = (R^2 * 1) / R and base * R = (base * R^2) / R
+        std::fill(one, one + width, 0);
+        std::fill(one, one + LANES, 1);
+        multiply(r_squared_digits.data(), one, table, acc);
+        multiply(base, r_squared_digits.data(), table + width, acc);
+        for (size_t i = 2; i < entries; ++i)
+        {
+            multiply(table + (i - 1) * width, table + width, table + i * width, acc);
+        }
+
+        const size_t bits = std::max(exponent.bitLength(), digits * DIGIT_BITS);
+        const size_t windows = (bits + WINDOW_BITS - 1) / WINDOW_BITS;
+        std::copy(table, table + width, x);
+        for (size_t w = windows; w-- > 0;)
+        {
+            if (w + 1 != windows)
+            {
+                for (int k = 0; k < WINDOW_BITS; ++k)
+                {
+                    multiply(x, x, x, acc);
+                }
+            }
+            size_t value = 0;
+            for (int k = WINDOW_BITS; k-- > 0;)
+            {
+                value = (value << 1) | (size_t)exponent.testBit(w * WINDOW_BITS + k);
+            }
+            std::fill(entry, entry + width, 0);
+            for (size_t i = 0; i < entries; ++i)
+            {
+                const Limb mask = 0 - (Limb)(i == value);
+                for (size_t j = 0; j < width; ++j)
+                {
+                    entry[j] |= table[i * width + j] & mask;
+                }
+            }
+            multiply(x, entry, x, acc);
+        }
+        multiply(x, one, r, acc);
+    }
+
+private:
+    // 16 table entries of a 1024 bit modulus take 20 KiB, which still fits in L1 next to the accumulator
+    static constexpr int WINDOW_BITS = 4;
+
+    size_t digits;
+    Limb m_inverse;
+    LimbVector modulus_digits;
+    LimbVector r_squared_digits;
+
+    static size_t digitCount(size_t bits)
+    {
+        return (bits + DIGIT_BITS - 1) / DIGIT_BITS;
+    }
+
+    // The accumulator window slides up one digit per step, so it needs 2d + 1 digits per lane
+    size_t accumulatorSize() const
+    {
+        return (2 * digits + 1) * LANES;
+    }
+
+#ifdef BIGNUMBER_X86_KERNELS
+    // GCC 12 reports the placeholder vectors inside its own AVX-512 shift intrinsics as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    // Lane wise Montgomery product a * b * R^-1 mod m, fully reduced into [0, m). Each step adds a[i] * b and
+    // q * m into the accumulator window t in one pass over the digits. The 52 bit products leave 12 bits of
+    // headroom per 64 bit lane, so the carries between digits wait until the end, apart from the carry out of
+    // the digit that the step clears.
+    __attribute__((target("avx512f,avx512ifma"))) void multiply(const Limb *a, const Limb *b, Limb *r, Limb *acc) const
+    {
+        const size_t d = digits;
+        const Limb *m = modulus_digits.data();
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i mask = _mm512_set1_epi64(DIGIT_MASK);
+        const __m512i inverse = _mm512_set1_epi64(m_inverse);
+
+        std::fill(acc, acc + accumulatorSize(), 0);
+        for (size_t i = 0; i < d; ++i)
+        {
+            Limb *t = acc + i * LANES;
+            __m512i ai = _mm512_loadu_si512(a + i * LANES);
+
+            // q makes the low digit of t + a[i] * b + q * m vanish, leaving only its carry
+            __m512i t0 = _mm512_madd52lo_epu64(_mm512_loadu_si512(t), ai, _mm512_loadu_si512(b));
+            __m512i q = _mm512_madd52lo_epu64(zero, t0, inverse);
+            t0 = _mm512_madd52lo_epu64(t0, q, _mm512_loadu_si512(m));
+            __m512i carry = _mm512_srli_epi64(t0, DIGIT_BITS);
+
+            for (size_t j = 1; j < d; ++j)
+            {
+                __m512i tj = _mm512_loadu_si512(t + j * LANES);
+                tj = _mm512_madd52lo_epu64(tj, ai, _mm512_loadu_si512(b + j * LANES));
+                tj = _mm512_madd52hi_epu64(tj, ai, _mm512_loadu_si512(b + (j - 1) * LANES));
+                tj = _mm512_madd52lo_epu64(tj, q, _mm512_loadu_si512(m + j * LANES));
+                tj = _mm512_madd52hi_epu64(tj, q, _mm512_loadu_si512(m + (j - 1) * LANES));
+                _mm512_storeu_si512(t + j * LANES, j == 1 ? _mm512_add_epi64(tj, carry) : tj);
+            }
+            __m512i top = _mm512_madd52hi_epu64(_mm512_loadu_si512(t + d * LANES), ai, _mm512_loadu_si512(b + (d - 1) * LANES));
+            top = _mm512_madd52hi_epu64(top, q, _mm512_loadu_si512(m + (d - 1) * LANES));
+            _mm512_storeu_si512(t + d * LANES, d == 1 ? _mm512_add_epi64(top, carry) : top);
+        }
+
+        // Normalize the d + 1 digits of the result, which is below 2m
+        Limb *t = acc + d * LANES;
+        for (size_t j = 0; j < d; ++j)
+        {
+            __m512i tj = _mm512_loadu_si512(t + j * LANES);
+            _mm512_storeu_si512(t + (j + 1) * LANES, _mm512_add_epi64(_mm512_loadu_si512(t + (j + 1) * LANES), _mm512_srli_epi64(tj, DIGIT_BITS)));
+            _mm512_storeu_si512(t + j * LANES, _mm512_and_si512(tj, mask));
+        }
+
+        // Subtract m, then keep the difference in the lanes where it did not go negative
+        __m512i borrow = zero;
+        for (size_t j = 0; j < d; ++j)
+        {
+            __m512i diff = _mm512_sub_epi64(_mm512_sub_epi64(_mm512_loadu_si512(t + j * LANES), _mm512_loadu_si512(m + j * LANES)), borrow);
+            borrow = _mm512_srli_epi64(diff, BigNumber::LIMB_BITS - 1);
+            _mm512_storeu_si512(r + j * LANES, _mm512_and_si512(diff, mask));
+        }
+        __mmask8 below_m = _mm512_cmplt_epi64_mask(_mm512_sub_epi64(_mm512_loadu_si512(t + d * LANES), borrow), zero);
+        for (size_t j = 0; j < d; ++j)
+        {
+            _mm512_storeu_si512(r + j * LANES, _mm512_mask_blend_epi64(below_m, _mm512_loadu_si512(r + j * LANES), _mm512_loadu_si512(t + j * LANES)));
+        }
+    }
+#pragma GCC diagnostic pop
+#else
+    void multiply(const Limb *, const Limb *, Limb *, Limb *) const
+    {
+        throw std::logic_error("MontgomeryLanes requires AVX-512 IFMA");
+    }
+#endif
+};
+
+// Precomputed reduction modulo a fixed modulus m of n limbs that avoids long division. Powers of two reduce
+// by masking, pseudo-Mersenne moduli 2^k - c with a single limb c by folding the bits above k back in times c,
+// and every other modulus (even ones included) by Barrett reduction with mu = floor(2^(128n) / m).
+class Reducer
+{
+public:
+    using Limb = BigNumber::Limb;
+    using LimbVector = BigNumber::LimbVector;
+
+    enum class Kind
+    {
+        PowerOfTwo,
+        PseudoMersenne,
+        Barrett
+    };
+
+    explicit Reducer(const BigNumber &modulus)
+        : modulus_value(modulus.absolute()), reduction_kind(classify(modulus))
+    {
+        const LimbVector &m = modulus_value.number_limbs;
+        if (m.size() == 1 && m[0] == 0)
+        {
+            throw std::invalid_argument("Division by zero");
+        }
+
+        bits = modulus_value.bitLength();
+        if (reduction_kind == Kind::PowerOfTwo)
+        {
+            --bits; // m = 2^bits
+        }
+        else if (reduction_kind == Kind::PseudoMersenne)
+        {
+            fold_factor = 0 - m[0]; // m = 2^bits - c
+        }
+        else
+        {
+            BigNumber power;
+            power.number_limbs.assign(2 * m.size() + 1, 0);
+            power.number_limbs.back() = 1;
+            mu = (power / modulus_value).number_limbs;
+        }
+    }
+
+    // Which reduction a modulus gets; cheap enough to call on every operation
+    static Kind classify(const BigNumber &modulus)
+    {
+        const LimbVector &m = modulus.number_limbs;
+        const size_t n = m.size();
+        const Limb top = m[n - 1];
+        const bool low_limbs_zero = std::all_of(m.begin(), m.end() - 1, [](Limb limb) { return limb == 0; });
+        if (low_limbs_zero && top != 0 && (top & (top - 1)) == 0)
+        {
+            return Kind::PowerOfTwo;
+        }
+
+        // 2^k - c with 0 < c < 2^64 and k >= 128 has all bits from 64 up to k - 1 set and a non-zero low limb
+        const bool middle_ones = std::all_of(m.begin() + 1, m.end() - 1, [](Limb limb) { return limb == ~Limb(0); });
+        if (n >= 3 && m[0] != 0 && middle_ones && (top & (top + 1)) == 0)
+        {
+            return Kind::PseudoMersenne;
+        }
+        return Kind::Barrett;
+    }
+
+    Kind kind() const
+    {
+        return reduction_kind;
+    }
+
+    // The (positive) modulus this reducer reduces by
+    const BigNumber &modulus() const
+    {
+        return modulus_value;
+    }
+
+    // value % modulus with the same sign convention as operator%
+    BigNumber reduce(const BigNumber &value) const
+    {
+        BigNumber result = value;
+        reduceInPlace(result);
+        return result;
+    }
+
+    // value %= modulus in place, reusing the storage of value
+    void reduceInPlace(BigNumber &value) const
+    {
+        LimbVector &x = value.number_limbs;
+        const LimbVector &m = modulus_value.number_limbs;
+        if (BigNumber::compareLimbs(x.data(), x.size(), m.data(), m.size()) < 0)
+        {
+            return;
+        }
+
+        switch (reduction_kind)
+        {
+        case Kind::PowerOfTwo:
+            keepLowBits(x, bits);
+            break;
+        case Kind::PseudoMersenne:
+            fold(x, m, bits, fold_factor);
+            break;
+        case Kind::Barrett:
+            if (x.size() > 2 * m.size())
+            {
+                // Barrett needs value < 2^(128n); anything wider takes the division
+                value %= modulus_value;
+                return;
+            }
+            barrett(x);
+            break;
+        }
+        value.trimLeadingZeros();
+    }
+
+    // x mod 2^k in place
+    static void keepLowBits(LimbVector &x, size_t k)
+    {
+        const size_t n = (k + BigNumber::LIMB_BITS - 1) / BigNumber::LIMB_BITS;
+        if (x.size() < n)
+        {
+            return;
+        }
+        x.resize(n);
+        if (k % BigNumber::LIMB_BITS != 0)
+        {
+            x[n - 1] &= (Limb(1) << (k % BigNumber::LIMB_BITS)) - 1;
+        }
+        trim(x);
+    }
+
+    // x mod (m = 2^k - c) in place. Since 2^k = c mod m, x = hi * 2^k + lo folds to lo + hi * c,
+    // shrinking by about k - 64 bits per round, and a final subtraction or two lands in [0, m)
+    static void fold(LimbVector &x, const LimbVector &m, size_t k, Limb c)
+    {
+        const size_t skip = k / BigNumber::LIMB_BITS;
+        const int shift = k % BigNumber::LIMB_BITS;
+        while (x.size() > skip + 1 || (x.size() == skip + 1 && (x[skip] >> shift) != 0))
+        {
+            const size_t hn = x.size() - skip;
+            BigNumber::ScratchLimbs high(hn);
+            BigNumber::shiftRightLimbs(high.data(), x.data() + skip, hn, shift);
+
+            keepLowBits(x, k);
+            x.resize(std::max(x.size(), hn + 1) + 1, 0);
+            Limb carry = BigNumber::mulAddLimbs(x.data(), high.data(), hn, c);
+            BigNumber::addLimbs(x.data() + hn, x.data() + hn, x.size() - hn, &carry, 1);
+            trim(x);
+        }
+        while (BigNumber::compareLimbs(x.data(), x.size(), m.data(), m.size()) >= 0)
+        {
+            BigNumber::subLimbs(x.data(), x.data(), x.size(), m.data(), m.size());
+            trim(x);
+        }
+    }
+
+private:
+    BigNumber modulus_value;
+    Kind reduction_kind;
+    size_t bits = 0;      // k for 2^k and 2^k - c
+    Limb fold_factor = 0; // c for 2^k - c
+    LimbVector mu;        // floor(2^(128n) / m) for Barrett
+
+    // Barrett reduction (HAC 14.42) in place of m <= x < 2^(128n): estimate the quotient as
+    // floor(floor(x / b^(n-1)) * mu / b^(n+1)), which is at most two below the truth, and finish with up to two subtractions
+    void barrett(LimbVector &x) const
+    {
+        const LimbVector &m = modulus_value.number_limbs;
+        const size_t n = m.size();
+
+        const size_t q1n = x.size() - (n - 1);
+        BigNumber::ScratchLimbs q2(q1n + mu.size());
+        multiply(q2.data(), x.data() + (n - 1), q1n, mu.data(), mu.size());
+
+        const size_t q3n = q1n + mu.size() - (n + 1);
+        BigNumber::ScratchLimbs q3m(q3n + n);
+        multiply(q3m.data(), q2.data() + (n + 1), q3n, m.data(), n);
+
+        // Only the low n + 1 limbs matter, the difference is taken mod b^(n+1)
+        x.resize(n + 1, 0);
+        BigNumber::subLimbs(x.data(), x.data(), n + 1, q3m.data(), n + 1);
+
+        trim(x);
+        while (BigNumber::compareLimbs(x.data(), x.size(), m.data(), n) >= 0)
+        {
+            BigNumber::subLimbs(x.data(), x.data(), x.size(), m.data(), n);
+            trim(x);
+        }
+    }
+
+    // r = a * b for operands in either order, with pooled scratch
+    static void multiply(Limb *r, const Limb *a, size_t an, const Limb *b, size_t bn)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        BigNumber::ScratchLimbs scratch(BigNumber::mulScratchSize(an));
+        BigNumber::mulLimbs(r, a, an, b, bn, scratch.data());
+    }
+
+    static void trim(LimbVector &x)
+    {
+        while (x.size() > 1 && x.back() == 0)
+        {
+            x.pop_back();
+        }
+    }
+};
+
+// Reduce in place by a modulus with a mask or a fold when it has a special form, otherwise by long division
+inline void BigNumber::reduceModulo(BigNumber &value, const BigNumber &modulus)
+{
+    switch (Reducer::classify(modulus))
+    {
+    case Reducer::Kind::PowerOfTwo:
+        Reducer::keepLowBits(value.number_limbs, modulus.bitLength() - 1);
+        break;
+    case Reducer::Kind::PseudoMersenne:
+        Reducer::fold(value.number_limbs, modulus.number_limbs, modulus.bitLength(), 0 - modulus.number_limbs[0]);
+        break;
+    case Reducer::Kind::Barrett:
+        value %= modulus;
+        return;
+    }
+    value.trimLeadingZeros();
+}
+
+inline BigNumber BigNumber::modAddition(const BigNumber &other_number, const Reducer &reducer) const
+{
+    BigNumber result = *this + other_number;
+    reducer.reduceInPlace(result);
+    return result;
+}
+
+inline BigNumber BigNumber::modMultiplication(const BigNumber &other_number, const Reducer &reducer) const
+{
+    BigNumber result = *this * other_number;
+    reducer.reduceInPlace(result);
+    return result;
+}
+
+// Modular multiplication against a precomputed Montgomery context: a * b mod m without any division.
+// Like the modulus overload, the result takes the sign of the product.
+inline BigNumber BigNumber::modMultiplication(const BigNumber &other_number, const MontgomeryContext &context) const
+{
+    // aR * b * R^-1 = ab mod m, so one conversion and one product suffice
+    BigNumber result = context.multiply(context.toMontgomery(*this), context.reduce(other_number));
+    result.isNegative = isNegative != other_number.isNegative;
+    result.trimLeadingZeros();
+    return result;
+}
+
+// Modular exponentiation with a sliding window over a table of odd powers. Odd moduli go through a
+// MontgomeryContext; even moduli reduce each product with a Reducer.
+inline BigNumber BigNumber::modPow(const BigNumber &exponent, const BigNumber &modulus) const
+{
+    if (exponent.isNegative)
+    {
+        throw std::invalid_argument("Negative exponent");
+    }
+    if (modulus.isZero())
+    {
+        countDivisionByZero();
+        std::cout << "Does not exist" << std::endl;
+        return BigNumber();
+    }
+
+    BigNumber m = modulus.absolute();
+    if (m.isOne())
+    {
+        return BigNumber();
+    }
+    if ((m.number_limbs[0] & 1) != 0)
+    {
+        return modPow(exponent, MontgomeryContext(m));
+    }
+
+    // Odd moduli are counted by the context overload
+    OperationProbe probe(Operation::ModPow, m.number_limbs.size());
+    Reducer reducer(m);
+    BigNumber base = reducer.reduce(*this);
+    if (base.isNegative)
+    {
+        base = base + m;
+    }
+    return windowedPow(exponent, base, BigNumber(1),
+                       [&reducer](BigNumber &r, const BigNumber &a, const BigNumber &b) { r = reducer.reduce(a * b); });
+}
+
+inline BigNumber BigNumber::modPow(const BigNumber &exponent, const MontgomeryContext &context) const
+{
+    OperationProbe probe(Operation::ModPow, context.size());
+    if (exponent.isNegative)
+    {
+        throw std::invalid_argument("Negative exponent");
+    }
+
+    // Bring the base into [0, m) before converting it
+    BigNumber base = context.reduce(*this);
+    if (isNegative && !base.isZero())
+    {
+        base = context.modulus() - base;
+    }
+
+    ScratchLimbs scratch(2 * context.size() + 2);
+    LimbVector result = windowedPow(exponent, context.padded(context.toMontgomery(base)), context.padded(context.one()),
+                                    [&context, &scratch](LimbVector &r, const LimbVector &a, const LimbVector &b)
+                                    { context.multiplyLimbs(r.data(), a.data(), b.data(), scratch.data()); });
+    return context.fromMontgomery(fromLimbs(result.data(), result.size()));
+}
+
+inline BigNumber BigNumber::multiModPow(const std::vector<BigNumber> &bases, const std::vector<BigNumber> &exponents,
+                                        const BigNumber &modulus)
+{
+    if (bases.size() != exponents.size())
+    {
+        throw std::invalid_argument("Bases and exponents differ in count");
+    }
+    for (const BigNumber &exponent : exponents)
+    {
+        if (exponent.isNegative)
+        {
+            throw std::invalid_argument("Negative exponent");
+        }
+    }
+    if (modulus.isZero())
+    {
+        countDivisionByZero();
+        std::cout << "Does not exist" << std::endl;
+        return BigNumber();
+    }
+
+    BigNumber m = modulus.absolute();
+    if (m.isOne())
+    {
+        return BigNumber();
+    }
+    if ((m.number_limbs[0] & 1) != 0)
+    {
+        MontgomeryContext context(m);
+        std::vector<LimbVector> residues;
+        residues.reserve(bases.size());
+        for (const BigNumber &base : bases)
+        {
+            BigNumber reduced = context.reduce(base);
+            if (base.isNegative && !reduced.isZero())
+            {
+                reduced = m - reduced;
+            }
+            residues.push_back(context.padded(context.toMontgomery(reduced)));
+        }
+
+        ScratchLimbs scratch(2 * context.size() + 2);
+        LimbVector result = multiPow(exponents, residues, context.padded(context.one()),
+                                     [&context, &scratch](LimbVector &r, const LimbVector &a, const LimbVector &b)
+                                     { context.multiplyLimbs(r.data(), a.data(), b.data(), scratch.data()); });
+        return context.fromMontgomery(fromLimbs(result.data(), result.size()));
+    }
+
+    Reducer reducer(m);
+    std::vector<BigNumber> residues;
+    residues.reserve(bases.size());
+    for (const BigNumber &base : bases)
+    {
+        residues.push_back(reducer.reduce(base));
+        if (residues.back().isNegative)
+        {
+            residues.back() += m;
+        }
+    }
+    return multiPow(exponents, residues, BigNumber(1),
+                    [&reducer](BigNumber &r, const BigNumber &a, const BigNumber &b) { r = reducer.reduce(a * b); });
+}
+
+// With n - 1 = d * 2^s, n passes for witness a when a^d = 1 or a^(d * 2^i) = n - 1 for some i < s
+inline bool BigNumber::millerRabinRound(const MontgomeryContext &context, const BigNumber &witness)
+{
+    const BigNumber &n = context.modulus();
+    const BigNumber minus_one = n - BigNumber(1);
+    size_t twos = 1;
+    while (!minus_one.testBit(twos))
+    {
+        ++twos;
+    }
+    BigNumber odd_part;
+    odd_part.number_limbs.resize(minus_one.number_limbs.size() - twos / LIMB_BITS);
+    shiftRightLimbs(odd_part.number_limbs.data(), minus_one.number_limbs.data() + twos / LIMB_BITS,
+                    odd_part.number_limbs.size(), twos % LIMB_BITS);
+    odd_part.trimLeadingZeros();
+
+    BigNumber x = witness.modPow(odd_part, context);
+    if (x.isOne() || x == minus_one)
+    {
+        return true;
+    }
+    for (size_t i = 1; i < twos; ++i)
+    {
+        x = x.modMultiplication(x, context);
+        if (x == minus_one)
+        {
+            return true;
+        }
+        if (x.isOne())
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+inline bool BigNumber::isProbablePrime(int rounds) const
+{
+    if (isNegative)
+    {
+        return false;
+    }
+    const std::vector<uint32_t> &primes = smallPrimes();
+    if (number_limbs.size() == 1 && number_limbs[0] < (Limb(1) << 32))
+    {
+        const Limb n = number_limbs[0];
+        if (n < 2 || n % 2 == 0)
+        {
+            return n == 2;
+        }
+        for (uint32_t p : primes)
+        {
+            if (Limb(p) * p > n)
+            {
+                break;
+            }
+            if (n % p == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    if ((number_limbs[0] & 1) == 0)
+    {
+        return false;
+    }
+
+    // Every small prime is below the number, so dividing by one means composite
+    uint32_t residues[TRIAL_DIVISION_PRIMES];
+    smallPrimeResidues(*this, TRIAL_DIVISION_PRIMES, residues);
+    if (std::find(residues, residues + TRIAL_DIVISION_PRIMES, 0) != residues + TRIAL_DIVISION_PRIMES)
+    {
+        return false;
+    }
+
+    MontgomeryContext context(*this);
+    for (int round = 0; round < std::max(rounds, 1); ++round)
+    {
+        if (!millerRabinRound(context, round == 0 ? BigNumber(2) : randomWitness(*this)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batch modular inversion with Montgomery's simultaneous inversion trick: one modInverse of the product of all
+// elements plus 3(n - 1) modular multiplications. Each element is replaced by its inverse in [0, modulus).
+// Elements with no inverse (zero, or sharing a factor with the modulus) are set to zero, which no invertible
+// element can map to, and the number of such elements is returned.
+inline size_t BigNumber::batchModInverse(std::vector<BigNumber> &values, const BigNumber &modulus)
+{
+    BigNumber m = modulus.absolute();
+    if (m.isZero())
+    {
+        throw std::invalid_argument("Modular inverse does not exist");
+    }
+
+    // Odd moduli multiply with Montgomery products directly on the residues: the powers of R^-1 picked up by the
+    // prefix products cancel against the ones in the backward pass, so no conversions are needed
+    std::unique_ptr<MontgomeryContext> context;
+    if ((m.number_limbs[0] & 1) != 0 && !m.isOne())
+    {
+        context.reset(new MontgomeryContext(m));
+    }
+    auto multiply = [&m, &context](const BigNumber &a, const BigNumber &b)
+    {
+        return context ? context->multiply(a, b) : (a * b) % m;
+    };
+
+    // Zeros have no inverse and take no part in the product
+    size_t failures = 0;
+    std::vector<size_t> indices;
+    indices.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        BigNumber residue = values[i] % m;
+        if (residue.isNegative)
+        {
+            residue = residue + m;
+        }
+        values[i] = residue;
+        if (residue.isZero())
+        {
+            ++failures;
+        }
+        else
+        {
+            indices.push_back(i);
+        }
+    }
+    if (indices.empty())
+    {
+        return failures;
+    }
+
+    // prefix[k] is the product of the first k + 1 non-zero elements
+    std::vector<BigNumber> prefix;
+    prefix.reserve(indices.size());
+    prefix.push_back(values[indices[0]]);
+    for (size_t k = 1; k < indices.size(); ++k)
+    {
+        prefix.push_back(multiply(prefix[k - 1], values[indices[k]]));
+    }
+
+    BigNumber inverse;
+    try
+    {
+        inverse = prefix.back().modInverse(m);
+    }
+    catch (const std::invalid_argument &)
+    {
+        // Some element shares a factor with the modulus; find out which by inverting one at a time
+        for (size_t i : indices)
+        {
+            try
+            {
+                values[i] = values[i].modInverse(m);
+            }
+            catch (const std::invalid_argument &)
+            {
+                values[i] = BigNumber();
+                ++failures;
+            }
+        }
+        return failures;
+    }
+
+    // Walk back: inverse holds the inverse of prefix[k], so times prefix[k - 1] it is the inverse of element k
+    for (size_t k = indices.size(); k-- > 1;)
+    {
+        BigNumber element = values[indices[k]];
+        values[indices[k]] = multiply(inverse, prefix[k - 1]);
+        inverse = multiply(inverse, element);
+    }
+    values[indices[0]] = inverse;
+    return failures;
+}
+
+// Batch modular multiplication sharing one modulus. Odd moduli precompute a MontgomeryContext once; with AVX-512
+// IFMA the products then run eight at a time through MontgomeryLanes, otherwise one at a time through the context.
+// Even moduli fall back to modMultiplication. Like modMultiplication, each result takes the sign of its product.
+inline void BigNumber::batchModMul(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n,
+                                   const BigNumber &modulus)
+{
+    BigNumber m = modulus.absolute();
+    if ((m.number_limbs[0] & 1) == 0 || m.isOne())
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i].modMultiplication(b[i], modulus, out[i]);
+        }
+        return;
+    }
+
+    MontgomeryContext context(m);
+    if (!MontgomeryLanes::available(m))
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = a[i].modMultiplication(b[i], context);
+        }
+        return;
+    }
+
+    const size_t lanes = MontgomeryLanes::LANES;
+    MontgomeryLanes engine(context);
+    ScratchLimbs scratch(2 * engine.size() * lanes);
+    Limb *a_digits = scratch.data();
+    Limb *b_digits = a_digits + engine.size() * lanes;
+    BigNumber reduced;
+    for (size_t block = 0; block < n; block += lanes)
+    {
+        const size_t count = std::min(lanes, n - block);
+        std::fill(a_digits, a_digits + 2 * engine.size() * lanes, 0);
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            // Operands already in (-m, m) only need their magnitude
+            const BigNumber &x = a[block + lane];
+            const BigNumber &y = b[block + lane];
+            engine.toDigits(x.compareAbsolute(m) < 0 ? x : (reduced = context.reduce(x)), a_digits + lane);
+            engine.toDigits(y.compareAbsolute(m) < 0 ? y : (reduced = context.reduce(y)), b_digits + lane);
+        }
+
+        engine.multiplyModulo(a_digits, b_digits, a_digits);
+
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            BigNumber &result = out[block + lane];
+            bool negative = a[block + lane].isNegative != b[block + lane].isNegative;
+            engine.fromDigits(a_digits + lane, result);
+            result.isNegative = negative && !result.isZero();
+        }
+    }
+}
+
+// Nodes of a lazy expression. Operands and moduli are held by reference and must outlive the expression.
+struct LazyOperand
+{
+    const BigNumber &value;
+};
+
+template <typename Left, typename Right>
+struct LazySum
+{
+    Left left;
+    Right right;
+};
+
+template <typename Left, typename Right>
+struct LazyDifference
+{
+    Left left;
+    Right right;
+};
+
+template <typename Left, typename Right>
+struct LazyProduct
+{
+    Left left;
+    Right right;
+};
+
+// Modulus is a BigNumber, a MontgomeryContext or a Reducer; all three give the sign convention of operator%
+template <typename Inner, typename Modulus>
+struct LazyRemainder
+{
+    Inner inner;
+    const Modulus &modulus;
+};
+
+// Evaluation of the expression trees. Remainders of a product of two operands, optionally plus a third operand,
+// run as fused kernels: the product and the addend meet in pooled scratch limbs and the reduction writes straight
+// into the storage of the result, so nothing is materialized in between. With a MontgomeryContext and operands in
+// [0, m) the reduction happens inside the multiplication loops. Other shapes evaluate bottom up with the in-place
+// operators.
+class LazyEvaluator
+{
+public:
+    using Limb = BigNumber::Limb;
+
+    template <typename Node>
+    static void evaluate(const Node &node, BigNumber &result)
+    {
+        if (writesResultLast(node))
+        {
+            evaluateInto(node, result);
+        }
+        else
+        {
+            // Evaluate into a fresh value, since the result may be one of the operands
+            BigNumber value;
+            evaluateInto(node, value);
+            result = std::move(value);
+        }
+    }
+
+private:
+    static void evaluateInto(const LazyOperand &node, BigNumber &value)
+    {
+        if (&node.value != &value)
+        {
+            value = node.value;
+        }
+    }
+
+    template <typename Left, typename Right>
+    static void evaluateInto(const LazySum<Left, Right> &node, BigNumber &value)
+    {
+        evaluateInto(node.left, value);
+        BigNumber storage;
+        value += operand(node.right, storage);
+    }
+
+    template <typename Left, typename Right>
+    static void evaluateInto(const LazyDifference<Left, Right> &node, BigNumber &value)
+    {
+        evaluateInto(node.left, value);
+        BigNumber storage;
+        value -= operand(node.right, storage);
+    }
+
+    template <typename Left, typename Right>
+    static void evaluateInto(const LazyProduct<Left, Right> &node, BigNumber &value)
+    {
+        evaluateInto(node.left, value);
+        BigNumber storage;
+        value *= operand(node.right, storage);
+    }
+
+    template <typename Inner, typename Modulus>
+    static void evaluateInto(const LazyRemainder<Inner, Modulus> &node, BigNumber &value)
+    {
+        evaluateInto(node.inner, value);
+        reduce(value, node.modulus);
+    }
+
+    template <typename Modulus>
+    static void evaluateInto(const LazyRemainder<LazyProduct<LazyOperand, LazyOperand>, Modulus> &node,
+                             BigNumber &value)
+    {
+        multiplyAddReduce(node.inner.left.value, node.inner.right.value, nullptr, node.modulus, value);
+    }
+
+    template <typename Modulus>
+    static void evaluateInto(const LazyRemainder<LazySum<LazyProduct<LazyOperand, LazyOperand>, LazyOperand>, Modulus> &node,
+                             BigNumber &value)
+    {
+        multiplyAddReduce(node.inner.left.left.value, node.inner.left.right.value, &node.inner.right.value,
+                          node.modulus, value);
+    }
+
+    template <typename Modulus>
+    static void evaluateInto(const LazyRemainder<LazySum<LazyOperand, LazyProduct<LazyOperand, LazyOperand>>, Modulus> &node,
+                             BigNumber &value)
+    {
+        multiplyAddReduce(node.inner.right.left.value, node.inner.right.right.value, &node.inner.left.value,
+                          node.modulus, value);
+    }
+
+    template <typename Modulus>
+    static void evaluateInto(const LazyRemainder<LazySum<LazyOperand, LazyOperand>, Modulus> &node, BigNumber &value)
+    {
+        const BigNumber &a = node.inner.left.value;
+        const BigNumber &b = node.inner.right.value;
+        if (&value == &b)
+        {
+            value += a;
+        }
+        else
+        {
+            if (&value != &a)
+            {
+                value = a;
+            }
+            value += b;
+        }
+        reduce(value, node.modulus);
+    }
+
+    // Whether evaluateInto only writes its output once the operands have been read, so it may alias them
+    template <typename Node>
+    static constexpr bool writesResultLast(const Node &)
+    {
+        return false;
+    }
+
+    static constexpr bool writesResultLast(const LazyOperand &)
+    {
+        return true;
+    }
+
+    template <typename Inner, typename Modulus>
+    static constexpr bool writesResultLast(const LazyRemainder<Inner, Modulus> &node)
+    {
+        return isFused(node.inner);
+    }
+
+    // The remainder shapes with a fused kernel: a * b, a * b + c, c + a * b and a + b over operands
+    template <typename Node>
+    static constexpr bool isFused(const Node &)
+    {
+        return false;
+    }
+
+    static constexpr bool isFused(const LazyProduct<LazyOperand, LazyOperand> &)
+    {
+        return true;
+    }
+
+    static constexpr bool isFused(const LazySum<LazyProduct<LazyOperand, LazyOperand>, LazyOperand> &)
+    {
+        return true;
+    }
+
+    static constexpr bool isFused(const LazySum<LazyOperand, LazyProduct<LazyOperand, LazyOperand>> &)
+    {
+        return true;
+    }
+
+    static constexpr bool isFused(const LazySum<LazyOperand, LazyOperand> &)
+    {
+        return true;
+    }
+
+    // A subexpression as a BigNumber: operands directly, anything else evaluated into storage
+    static const BigNumber &operand(const LazyOperand &node, BigNumber &)
+    {
+        return node.value;
+    }
+
+    template <typename Node>
+    static const BigNumber &operand(const Node &node, BigNumber &storage)
+    {
+        evaluateInto(node, storage);
+        return storage;
+    }
+
+    static void reduce(BigNumber &value, const BigNumber &modulus)
+    {
+        BigNumber::reduceModulo(value, modulus);
+    }
+
+    static void reduce(BigNumber &value, const MontgomeryContext &context)
+    {
+        BigNumber::reduceModulo(value, context.modulus());
+    }
+
+    static void reduce(BigNumber &value, const Reducer &reducer)
+    {
+        reducer.reduceInPlace(value);
+    }
+
+    // result = (a * b + c) % modulus, with c optional. The product goes to scratch and the addend is added or
+    // subtracted there by sign, so result is only written at the end and may alias any operand.
+    template <typename Modulus>
+    static void multiplyAddReduce(const BigNumber &a, const BigNumber &b, const BigNumber *c, const Modulus &modulus,
+                                  BigNumber &result)
+    {
+        const BigNumber &longer = a.number_limbs.size() >= b.number_limbs.size() ? a : b;
+        const BigNumber &shorter = &longer == &a ? b : a;
+        const size_t an = longer.number_limbs.size();
+        const size_t bn = shorter.number_limbs.size();
+        const size_t cn = c != nullptr ? c->number_limbs.size() : 1;
+        const size_t tn = std::max(an + bn, cn) + 1;
+
+        BigNumber::OperationProbe probe(BigNumber::Operation::Multiply, an);
+        BigNumber::ScratchLimbs product(tn), scratch(BigNumber::mulScratchSize(an));
+        Limb *t = product.data();
+        BigNumber::mulLimbs(t, longer.number_limbs.data(), an, shorter.number_limbs.data(), bn, scratch.data());
+        std::fill(t + an + bn, t + tn, 0);
+        bool negative = a.isNegative != b.isNegative;
+
+        if (c != nullptr && !c->isZero())
+        {
+            const Limb *cl = c->number_limbs.data();
+            if (c->isNegative == negative)
+            {
+                t[tn - 1] = BigNumber::addLimbs(t, t, tn - 1, cl, cn);
+            }
+            else
+            {
+                size_t used = an + bn;
+                while (used > 1 && t[used - 1] == 0)
+                {
+                    --used;
+                }
+                if (BigNumber::compareLimbs(t, used, cl, cn) >= 0)
+                {
+                    BigNumber::subLimbs(t, t, used, cl, cn);
+                }
+                else
+                {
+                    // |c| > |a * b|, so the product fits in cn limbs and the sign is that of c
+                    BigNumber::subLimbs(t, cl, cn, t, cn);
+                    negative = c->isNegative;
+                }
+            }
+        }
+
+        result.number_limbs.assign(t, t + tn);
+        result.isNegative = negative;
+        result.trimLeadingZeros();
+        reduce(result, modulus);
+    }
+
+    // With a Montgomery context and non-negative operands in [0, m) the product is reduced inside the CIOS loops
+    // and the addend takes one conditional subtraction; anything else takes the general path
+    static void multiplyAddReduce(const BigNumber &a, const BigNumber &b, const BigNumber *c,
+                                  const MontgomeryContext &context, BigNumber &result)
+    {
+        const BigNumber &modulus = context.modulus();
+        const Limb *m = modulus.number_limbs.data();
+        const size_t n = context.size();
+        const auto reduced = [&](const BigNumber &x) {
+            return !x.isNegative && BigNumber::compareLimbs(x.number_limbs.data(), x.number_limbs.size(), m, n) < 0;
+        };
+        if (!reduced(a) || !reduced(b) || (c != nullptr && !reduced(*c)))
+        {
+            multiplyAddReduce<MontgomeryContext>(a, b, c, context, result);
+            return;
+        }
+
+        BigNumber::ScratchLimbs buffer(4 * n + 2);
+        Limb *pa = buffer.data();
+        Limb *pb = pa + n;
+        std::copy(a.number_limbs.begin(), a.number_limbs.end(), pa);
+        std::fill(pa + a.number_limbs.size(), pa + n, 0);
+        std::copy(b.number_limbs.begin(), b.number_limbs.end(), pb);
+        std::fill(pb + b.number_limbs.size(), pb + n, 0);
+        context.multiplyModuloLimbs(pa, pa, pb, pb + n);
+
+        if (c != nullptr)
+        {
+            const Limb carry = BigNumber::addLimbs(pa, pa, n, c->number_limbs.data(), c->number_limbs.size());
+            if (carry != 0 || BigNumber::compareLimbs(pa, n, m, n) >= 0)
+            {
+                BigNumber::subLimbs(pa, pa, n, m, n);
+            }
+        }
+
+        result.number_limbs.assign(pa, pa + n);
+        result.isNegative = false;
+        result.trimLeadingZeros();
+    }
+};
+
+// An unevaluated expression over BigNumbers, built from BigNumber::lazy() with +, -, * and %. Converting or
+// assigning it to a BigNumber evaluates it, e.g. r = (BigNumber::lazy(x) * y + z) % m runs as one fused
+// multiply-add-reduce into the storage of r.
+template <typename Node>
+class LazyExpression
+{
+public:
+    explicit LazyExpression(const Node &node)
+        : root(node)
+    {
+    }
+
+    const Node &node() const
+    {
+        return root;
+    }
+
+    // Evaluate into result, reusing its storage; result may be one of the operands
+    void evaluate(BigNumber &result) const
+    {
+        LazyEvaluator::evaluate(root, result);
+    }
+
+    operator BigNumber() const
+    {
+        BigNumber result;
+        evaluate(result);
+        return result;
+    }
+
+private:
+    Node root;
+};
+
+inline LazyExpression<LazyOperand> BigNumber::lazy(const BigNumber &value)
+{
+    return LazyExpression<LazyOperand>(LazyOperand{value});
+}
+
+// Tree node of either side of a lazy operator: BigNumbers become leaves, expressions contribute their root
+inline LazyOperand lazyNode(const BigNumber &value)
+{
+    return LazyOperand{value};
+}
+
+template <typename Node>
+const Node &lazyNode(const LazyExpression<Node> &expression)
+{
+    return expression.node();
+}
+
+template <typename T>
+struct IsLazyExpression : std::false_type
+{
+};
+
+template <typename Node>
+struct IsLazyExpression<LazyExpression<Node>> : std::true_type
+{
+};
+
+// The lazy operators take a lazy expression on at least one side and a BigNumber or lazy expression on the other
+template <typename A, typename B>
+using EnableLazy = std::enable_if_t<(IsLazyExpression<A>::value || std::is_same_v<A, BigNumber>) &&
+                                    (IsLazyExpression<B>::value || std::is_same_v<B, BigNumber>) &&
+                                    (IsLazyExpression<A>::value || IsLazyExpression<B>::value)>;
+
+template <typename A, typename B, typename = EnableLazy<A, B>>
+auto operator+(const A &a, const B &b)
+{
+    using Node = LazySum<std::decay_t<decltype(lazyNode(a))>, std::decay_t<decltype(lazyNode(b))>>;
+    return LazyExpression<Node>(Node{lazyNode(a), lazyNode(b)});
+}
+
+template <typename A, typename B, typename = EnableLazy<A, B>>
+auto operator-(const A &a, const B &b)
+{
+    using Node = LazyDifference<std::decay_t<decltype(lazyNode(a))>, std::decay_t<decltype(lazyNode(b))>>;
+    return LazyExpression<Node>(Node{lazyNode(a), lazyNode(b)});
+}
+
+template <typename A, typename B, typename = EnableLazy<A, B>>
+auto operator*(const A &a, const B &b)
+{
+    using Node = LazyProduct<std::decay_t<decltype(lazyNode(a))>, std::decay_t<decltype(lazyNode(b))>>;
+    return LazyExpression<Node>(Node{lazyNode(a), lazyNode(b)});
+}
+
+template <typename Inner>
+LazyExpression<LazyRemainder<Inner, BigNumber>> operator%(const LazyExpression<Inner> &expression,
+                                                          const BigNumber &modulus)
+{
+    return LazyExpression<LazyRemainder<Inner, BigNumber>>({expression.node(), modulus});
+}
+
+template <typename Inner>
+LazyExpression<LazyRemainder<Inner, MontgomeryContext>> operator%(const LazyExpression<Inner> &expression,
+                                                                  const MontgomeryContext &context)
+{
+    return LazyExpression<LazyRemainder<Inner, MontgomeryContext>>({expression.node(), context});
+}
+
+template <typename Inner>
+LazyExpression<LazyRemainder<Inner, Reducer>> operator%(const LazyExpression<Inner> &expression,
+                                                        const Reducer &reducer)
+{
+    return LazyExpression<LazyRemainder<Inner, Reducer>>({expression.node(), reducer});
+}
+
+// RSA private key in Chinese remainder form (PKCS #1): the primes p and q, dp = d mod (p - 1),
+// dq = d mod (q - 1) and qInv = q^-1 mod p. A private operation c^d mod n runs as two exponentiations of half
+// the size, one per prime, recombined with Garner's formula m = m2 + q * (qInv * (m1 - m2) mod p). Each prime
+// keeps a Montgomery context for its exponentiation and a Barrett reducer for bringing c down from mod n.
+//
+// Side channels: both exponentiations run a fixed window over the full prime size with a table lookup that reads
+// every entry (MontgomeryContext::fixedWindowPower(), MontgomeryLanes::power()), and the Montgomery product
+// subtracts without a branch, so the timing does not follow the bits of dp and dq. The reductions and Garner's
+// step around them are ordinary variable time BigNumber arithmetic on values derived from c. Passing the public
+// exponent e closes that gap: every input is then blinded as c * r^e with a fresh random r and unblinded
+// with r^-1 after recombination, and every result m is checked against m^e = c mod n, which throws instead of
+// releasing a faulty signature that would factor n. Keys built without e are not side channel hardened
+// against chosen inputs.
+class RsaPrivateKey
+{
+public:
+    using Limb = BigNumber::Limb;
+
+    // From the two primes and the private exponent d, and optionally the public exponent e (zero for none)
+    RsaPrivateKey(const BigNumber &p, const BigNumber &q, const BigNumber &d, const BigNumber &e = BigNumber())
+        : RsaPrivateKey(p, q, d % (checkedPrime(p) - 1), d % (checkedPrime(q) - 1), q.modInverse(checkedPrime(p)),
+                        e)
+    {
+    }
+
+    // From the stored CRT components; qInv must satisfy q * qInv = 1 mod p. dp and dq lie below p - 1 and q - 1.
+    RsaPrivateKey(const BigNumber &p, const BigNumber &q, const BigNumber &dp, const BigNumber &dq,
+                  const BigNumber &q_inverse, const BigNumber &e = BigNumber())
+        : prime_p(checkedPrime(p)), prime_q(checkedPrime(q)), exponent_p(dp), exponent_q(dq),
+          coefficient(q_inverse), modulus_value(p * q), public_exponent(e), context_p(p), context_q(q),
+          context_n(modulus_value), reducer_p(p), reducer_q(q)
+    {
+        if (p == q || dp < BigNumber() || dq < BigNumber() || dp >= p - 1 || dq >= q - 1 ||
+            !q.modMultiplication(q_inverse, reducer_p).isOne())
+        {
+            throw std::invalid_argument("Inconsistent CRT parameters");
+        }
+        if (e.isNegative || e.isOne())
+        {
+            throw std::invalid_argument("Invalid public exponent");
+        }
+        if (MontgomeryLanes::available(p) && MontgomeryLanes::available(q))
+        {
+            lanes_p = std::make_shared<const MontgomeryLanes>(context_p);
+            lanes_q = std::make_shared<const MontgomeryLanes>(context_q);
+        }
+    }
+
+    // The public modulus n = p * q
+    const BigNumber &modulus() const
+    {
+        return modulus_value;
+    }
+
+    // c^d mod n for c in [0, n), i.e. RSA decryption or signing. Blinded and checked when the key has e.
+    BigNumber privateOperation(const BigNumber &input) const
+    {
+        checkRange(input);
+        BigNumber unblinding;
+        const BigNumber blinded = blind(input, unblinding);
+        BigNumber m1 = context_p.fixedWindowPower(reducer_p.reduce(blinded), exponent_p);
+        BigNumber m2 = context_q.fixedWindowPower(reducer_q.reduce(blinded), exponent_q);
+        return unblind(input, recombine(m1, m2), unblinding);
+    }
+
+    // out[i] = privateOperation(inputs[i]) for i in [0, n); out may be the same array as inputs. With AVX-512 IFMA
+    // eight inputs at a time share each half size exponentiation, one per lane of the MontgomeryLanes engine.
+    void privateOperation(const BigNumber *inputs, BigNumber *out, size_t n) const
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            checkRange(inputs[i]);
+        }
+        if (!lanes_p)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                out[i] = privateOperation(inputs[i]);
+            }
+            return;
+        }
+
+        const size_t lanes = MontgomeryLanes::LANES;
+        BigNumber unblinding[MontgomeryLanes::LANES];
+        const size_t width_p = lanes_p->size() * lanes;
+        const size_t width_q = lanes_q->size() * lanes;
+        BigNumber::ScratchLimbs scratch(width_p + width_q);
+        Limb *digits_p = scratch.data();
+        Limb *digits_q = digits_p + width_p;
+        BigNumber m1, m2;
+        for (size_t block = 0; block < n; block += lanes)
+        {
+            const size_t count = std::min(lanes, n - block);
+            std::fill(digits_p, digits_p + width_p + width_q, 0);
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                const BigNumber blinded = blind(inputs[block + lane], unblinding[lane]);
+                lanes_p->toDigits(reducer_p.reduce(blinded), digits_p + lane);
+                lanes_q->toDigits(reducer_q.reduce(blinded), digits_q + lane);
+            }
+
+            lanes_p->power(digits_p, exponent_p, digits_p);
+            lanes_q->power(digits_q, exponent_q, digits_q);
+
+            for (size_t lane = 0; lane < count; ++lane)
+            {
+                lanes_p->fromDigits(digits_p + lane, m1);
+                lanes_q->fromDigits(digits_q + lane, m2);
+                // inputs may alias out, so unblind checks against the input before the result replaces it
+                out[block + lane] = unblind(inputs[block + lane], recombine(m1, m2), unblinding[lane]);
+            }
+        }
+    }
+
 private:
-    // Vector to store the digits of the number in reverse order (least significant digit first)
-    std::vector<int> number_digits;
-    bool isNegative = false;
+    BigNumber prime_p;
+    BigNumber prime_q;
+    BigNumber exponent_p;
+    BigNumber exponent_q;
+    BigNumber coefficient; // qInv
+    BigNumber modulus_value;
+    BigNumber public_exponent; // e, or zero when the key was built without it
+    MontgomeryContext context_p;
+    MontgomeryContext context_q;
+    MontgomeryContext context_n;
+    Reducer reducer_p;
+    Reducer reducer_q;
+    std::shared_ptr<const MontgomeryLanes> lanes_p;
+    std::shared_ptr<const MontgomeryLanes> lanes_q;
+
+    // RSA primes are odd and above two, which is also what the Montgomery contexts need
+    static const BigNumber &checkedPrime(const BigNumber &prime)
+    {
+        if (prime < BigNumber(3) || !prime.testBit(0))
+        {
+            throw std::invalid_argument("RSA primes must be odd and greater than two");
+        }
+        return prime;
+    }
+
+    void checkRange(const BigNumber &input) const
+    {
+        if (input < BigNumber() || input >= modulus_value)
+        {
+            throw std::invalid_argument("Input out of range");
+        }
+    }
+
+    // c * r^e mod n for a fresh random r in [2, n) coprime to n, with r^-1 mod n in unblinding; c itself when
+    // the key has no e
+    BigNumber blind(const BigNumber &input, BigNumber &unblinding) const
+    {
+        if (public_exponent.isZero())
+        {
+            return input;
+        }
+        thread_local std::random_device entropy;
+        while (true)
+        {
+            BigNumber r;
+            r.number_limbs.resize(modulus_value.number_limbs.size() + 1);
+            for (Limb &limb : r.number_limbs)
+            {
+                limb = (Limb(entropy()) << 32) | entropy();
+            }
+            r = r % (modulus_value - BigNumber(2)) + BigNumber(2);
+            try
+            {
+                unblinding = r.modInverse(modulus_value);
+            }
+            catch (const std::invalid_argument &)
+            {
+                // r shares a prime with n, which a random draw essentially never does
+                continue;
+            }
+            return input.modMultiplication(r.modPow(public_exponent, context_n), context_n);
+        }
+    }
+
+    // Undo blind() on the result of the blinded input and check it against the public exponent
+    BigNumber unblind(const BigNumber &input, const BigNumber &result, const BigNumber &unblinding) const
+    {
+        if (public_exponent.isZero())
+        {
+            return result;
+        }
+        BigNumber m = result.modMultiplication(unblinding, context_n);
+        if (m.modPow(public_exponent, context_n) != input)
+        {
+            throw std::runtime_error("RSA private operation failed its public exponent check");
+        }
+        return m;
+    }
+
+    // Garner recombination of m1 = c^d mod p and m2 = c^d mod q
+    BigNumber recombine(const BigNumber &m1, const BigNumber &m2) const
+    {
+        BigNumber difference = m1 - reducer_p.reduce(m2);
+        if (difference < BigNumber())
+        {
+            difference += prime_p;
+        }
+        return m2 + difference.modMultiplication(coefficient, reducer_p) * prime_q;
+    }
+};
 
+// Work stealing thread pool with batch entry points for the modular operations. Each batch is cut into chunks
+// sized by the cost of one element at the modulus size, so 512 bit and 2048 bit batches both spread evenly over
+// the workers. Every worker owns a deque: it runs its own chunks newest first and, once it runs dry, steals the
+// oldest chunks of the others. Any number of threads may submit batches concurrently; a blocking call runs
+// chunks itself while it waits, so it is also safe to call from inside a worker.
+class BatchExecutor
+{
 public:
-    // Default constructor to initialize BigNumber to zero
-    BigNumber()
+    // threads == 0 uses one worker per hardware thread. With pin_threads, worker i is bound to the i-th CPU the
+    // process may run on (Linux only, ignored elsewhere).
+    explicit BatchExecutor(size_t threads = 0, bool pin_threads = false)
+    {
+        if (threads == 0)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<int> cpus = pin_threads ? allowedCpus() : std::vector<int>();
+        for (size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < threads; ++i)
+        {
+            workers[i]->thread = std::thread([this, i] { workerLoop(i); });
+            if (!cpus.empty())
+            {
+                pin(workers[i]->thread, cpus[i % cpus.size()]);
+            }
+        }
+    }
+
+    // Finishes every submitted chunk before joining the workers
+    ~BatchExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::unique_ptr<Worker> &worker : workers)
+        {
+            worker->thread.join();
+        }
+    }
+
+    BatchExecutor(const BatchExecutor &) = delete;
+    BatchExecutor &operator=(const BatchExecutor &) = delete;
+
+    size_t threadCount() const
+    {
+        return workers.size();
+    }
+
+    // out[i] = a[i].modAddition(b[i], modulus) for i in [0, n). The arrays must stay alive until the returned
+    // future is ready; out may be the same array as a or b.
+    std::future<void> modAdditionAsync(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n,
+                                       const BigNumber &modulus)
+    {
+        const BigNumber m = modulus;
+        return schedule<void>(n, limbCount(m), 1,
+                              [a, b, out, m](size_t begin, size_t end)
+                              {
+                                  for (size_t i = begin; i < end; ++i)
+                                  {
+                                      a[i].modAddition(b[i], m, out[i]);
+                                  }
+                              });
+    }
+
+    // out[i] = a[i].modMultiplication(b[i], modulus), chunk by chunk through BigNumber::batchModMul
+    std::future<void> modMultiplicationAsync(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n,
+                                             const BigNumber &modulus)
+    {
+        const BigNumber m = modulus;
+        const size_t limbs = limbCount(m);
+        return schedule<void>(n, limbs * limbs, MIN_MODULAR_CHUNK,
+                              [a, b, out, m](size_t begin, size_t end)
+                              { BigNumber::batchModMul(a + begin, b + begin, out + begin, end - begin, m); });
+    }
+
+    // out[i] = a[i]^-1 mod modulus, chunk by chunk through BigNumber::batchModInverse. Elements with no inverse
+    // are set to zero, and the future yields how many there were.
+    std::future<size_t> modInverseAsync(const BigNumber *a, BigNumber *out, size_t n, const BigNumber &modulus)
+    {
+        const BigNumber m = modulus;
+        const size_t limbs = limbCount(m);
+        auto failures = std::make_shared<std::atomic<size_t>>(0);
+        return schedule<size_t>(n, 4 * limbs * limbs, MIN_MODULAR_CHUNK,
+                                [a, out, m, failures](size_t begin, size_t end)
+                                {
+                                    std::vector<BigNumber> values(a + begin, a + end);
+                                    *failures += BigNumber::batchModInverse(values, m);
+                                    std::move(values.begin(), values.end(), out + begin);
+                                },
+                                [failures] { return failures->load(); });
+    }
+
+    // Blocking forms of the above
+    void modAddition(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n, const BigNumber &modulus)
+    {
+        wait(modAdditionAsync(a, b, out, n, modulus));
+    }
+
+    void modMultiplication(const BigNumber *a, const BigNumber *b, BigNumber *out, size_t n, const BigNumber &modulus)
+    {
+        wait(modMultiplicationAsync(a, b, out, n, modulus));
+    }
+
+    size_t modInverse(const BigNumber *a, BigNumber *out, size_t n, const BigNumber &modulus)
+    {
+        return wait(modInverseAsync(a, out, n, modulus));
+    }
+
+    // Runs process(begin, end) over chunks covering [0, n) and returns once all of them have. element_cost is the
+    // work of one element in limb products, which sets the chunk size; the first exception thrown is rethrown.
+    void parallelFor(size_t n, size_t element_cost, std::function<void(size_t, size_t)> process)
+    {
+        wait(schedule<void>(n, element_cost, 1, std::move(process)));
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    // Outstanding chunks of one batch and the first exception any of them threw
+    template <typename Result>
+    struct Batch
+    {
+        std::promise<Result> promise;
+        std::atomic<size_t> remaining{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        std::function<void(size_t, size_t)> process;
+        std::function<Result()> finish;
+    };
+
+    // A chunk should carry about this many limb products of work to amortize scheduling and the per chunk
+    // Montgomery setup; modular multiplication and inversion chunks also never go below MIN_MODULAR_CHUNK elements
+    static constexpr size_t CHUNK_WORK = size_t(1) << 16;
+    static constexpr size_t MIN_MODULAR_CHUNK = 32;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> next_queue{0};
+    bool stopping = false;
+
+    static size_t limbCount(const BigNumber &modulus)
+    {
+        return (modulus.bitLength() + BigNumber::LIMB_BITS - 1) / BigNumber::LIMB_BITS + 1;
+    }
+
+    // The executor and worker index of the calling thread, if it is a worker
+    static std::pair<const BatchExecutor *, size_t> &currentWorker()
+    {
+        thread_local std::pair<const BatchExecutor *, size_t> current(nullptr, 0);
+        return current;
+    }
+
+    size_t chunkSize(size_t n, size_t element_cost, size_t min_chunk) const
+    {
+        size_t by_work = std::max<size_t>(1, CHUNK_WORK / std::max<size_t>(1, element_cost));
+        size_t by_balance = (n + 4 * workers.size() - 1) / (4 * workers.size());
+        return std::max(std::min(by_work, by_balance), min_chunk);
+    }
+
+    template <typename Result>
+    std::future<Result> schedule(size_t n, size_t element_cost, size_t min_chunk,
+                                 std::function<void(size_t, size_t)> process, std::function<Result()> finish = {})
+    {
+        auto batch = std::make_shared<Batch<Result>>();
+        batch->process = std::move(process);
+        batch->finish = std::move(finish);
+        std::future<Result> future = batch->promise.get_future();
+
+        const size_t chunk = chunkSize(n, element_cost, min_chunk);
+        const size_t chunks = (n + chunk - 1) / chunk;
+        if (chunks == 0)
+        {
+            complete(*batch);
+            return future;
+        }
+        batch->remaining = chunks;
+        for (size_t begin = 0; begin < n; begin += chunk)
+        {
+            const size_t end = std::min(n, begin + chunk);
+            submit([batch, begin, end]
+                   {
+                       try
+                       {
+                           batch->process(begin, end);
+                       }
+                       catch (...)
+                       {
+                           std::lock_guard<std::mutex> lock(batch->error_mutex);
+                           if (!batch->error)
+                           {
+                               batch->error = std::current_exception();
+                           }
+                       }
+                       if (batch->remaining.fetch_sub(1) == 1)
+                       {
+                           complete(*batch);
+                       }
+                   });
+        }
+        return future;
+    }
+
+    template <typename Result>
+    static void complete(Batch<Result> &batch)
+    {
+        if (batch.error)
+        {
+            batch.promise.set_exception(batch.error);
+            return;
+        }
+        try
+        {
+            if constexpr (std::is_void<Result>::value)
+            {
+                batch.promise.set_value();
+            }
+            else
+            {
+                batch.promise.set_value(batch.finish());
+            }
+        }
+        catch (...)
+        {
+            batch.promise.set_exception(std::current_exception());
+        }
+    }
+
+    // Workers push to their own deque; other threads spread chunks round robin
+    void submit(Task task)
+    {
+        std::pair<const BatchExecutor *, size_t> current = currentWorker();
+        size_t index = current.first == this ? current.second : next_queue++ % workers.size();
+        // Count the task before it becomes visible, so a thief's decrement can never take queued below zero
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            ++queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            workers[index]->tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Take the newest task of deque `home`, or else steal the oldest task of another deque
+    bool takeTask(size_t home, Task &task)
+    {
+        for (size_t k = 0; k < workers.size(); ++k)
+        {
+            Worker &worker = *workers[(home + k) % workers.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.tasks.empty())
+            {
+                if (k == 0)
+                {
+                    task = std::move(worker.tasks.back());
+                    worker.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(worker.tasks.front());
+                    worker.tasks.pop_front();
+                }
+                --queued;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index)
+    {
+        currentWorker() = std::make_pair(this, index);
+        Task task;
+        while (true)
+        {
+            if (takeTask(index, task))
+            {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wake.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0 && stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    // Wait for a batch, running queued chunks on the calling thread in the meantime
+    template <typename Result>
+    Result wait(std::future<Result> future)
+    {
+        std::pair<const BatchExecutor *, size_t> current = currentWorker();
+        size_t home = current.first == this ? current.second : 0;
+        Task task;
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            if (takeTask(home, task))
+            {
+                task();
+                task = nullptr;
+            }
+            else
+            {
+                future.wait_for(std::chrono::microseconds(100));
+            }
+        }
+        return future.get();
+    }
+
+    static std::vector<int> allowedCpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return cpus;
+    }
+
+    static void pin(std::thread &thread, int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+};
+
+inline BigNumber BigNumber::generatePrime(size_t bits, int rounds)
+{
+    return searchPrime(bits, nullptr, rounds);
+}
+
+inline BigNumber BigNumber::generatePrime(size_t bits, BatchExecutor &executor, int rounds)
+{
+    return searchPrime(bits, &executor, rounds);
+}
+
+// Candidates start + 2k for k in [0, SIEVE_INTERVAL) are struck off for every small prime p dividing them, which
+// only takes start mod p per interval. The survivors get a base 2 round in order, and the first to pass gets
+// the remaining rounds. With an executor, the base 2 rounds run on as many consecutive survivors at once as
+// there are workers, and the remaining rounds of a candidate all run at once.
+inline BigNumber BigNumber::searchPrime(size_t bits, BatchExecutor *executor, int rounds)
+{
+    if (bits < 2)
     {
-        number_digits.push_back(0);
-        isNegative = false;
+        throw std::invalid_argument("Primes have at least two bits");
     }
-
-    // Constructor from long long
-    BigNumber(long long num)
+    std::random_device entropy;
+    auto parallelFor = [executor](size_t n, size_t element_cost, std::function<void(size_t, size_t)> process)
     {
-        if (num == 0)
+        if (executor != nullptr)
         {
-            number_digits.push_back(0);
-            isNegative = false;
-            return;
+            executor->parallelFor(n, element_cost, std::move(process));
         }
-
-        isNegative = (num < 0);
-        num = std::abs(num);
-
-        while (num > 0)
+        else
         {
-            number_digits.push_back(num % 10);
-            num /= 10;
+            process(0, n);
         }
-    }
+    };
 
-    // Constructor to initialize BigNumber from a string
-    BigNumber(const std::string &number)
+    // Below the sieve bound a candidate could be one of the sieving primes, so small primes are drawn directly
+    if (bits <= 32)
     {
-        if (number.empty())
+        for (;;)
         {
-            number_digits.push_back(0);
-            isNegative = false;
-            return;
+            BigNumber candidate = randomCandidate(bits, entropy);
+            if (candidate.isProbablePrime(rounds))
+            {
+                return candidate;
+            }
         }
+    }
 
-        size_t start = 0; // Start position for reading digits
-
-        // Check for sign
-        if (number[0] == '-')
+    const std::vector<uint32_t> &primes = smallPrimes();
+    const size_t limbs = (bits + LIMB_BITS - 1) / LIMB_BITS;
+    const size_t test_cost = limbs * limbs * bits;
+    std::vector<uint32_t> residues(primes.size());
+    std::vector<char> composite(SIEVE_INTERVAL);
+    std::vector<BigNumber> survivors;
+    for (;;)
+    {
+        const BigNumber start = randomCandidate(bits, entropy);
+        smallPrimeResidues(start, primes.size(), residues.data());
+        std::fill(composite.begin(), composite.end(), 0);
+        for (size_t i = 0; i < primes.size(); ++i)
         {
-            isNegative = true;
-            start = 1; // Start after the negative sign
+            // start + 2k = 0 mod p for k = -start / 2 mod p
+            const Limb p = primes[i];
+            for (Limb k = (p - residues[i]) % p * ((p + 1) / 2) % p; k < SIEVE_INTERVAL; k += p)
+            {
+                composite[k] = 1;
+            }
         }
-        else if (number[0] == '+')
+
+        survivors.clear();
+        for (size_t k = 0; k < SIEVE_INTERVAL; ++k)
         {
-            start = 1; // Start after the positive sign
+            if (composite[k] == 0)
+            {
+                BigNumber candidate = start + BigNumber((long long)(2 * k));
+                if (candidate.bitLength() == bits)
+                {
+                    survivors.push_back(std::move(candidate));
+                }
+            }
         }
 
-        // Read the string in reverse order to fill digits
-        number_digits.clear();
-        for (size_t i = number.length(); i > start; --i)
+        // Test the survivors in order, as many at a time as there are workers
+        const size_t width = executor != nullptr ? executor->threadCount() : 1;
+        std::vector<char> passed(width);
+        for (size_t next = 0; next < survivors.size(); next += width)
         {
-            char c = number[i - 1];
-            if (!std::isdigit(c))
+            const size_t count = std::min(width, survivors.size() - next);
+            parallelFor(count, test_cost,
+                        [&survivors, &passed, next](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                passed[i] = millerRabinRound(MontgomeryContext(survivors[next + i]), BigNumber(2));
+                            }
+                        });
+
+            for (size_t i = 0; i < count; ++i)
             {
-                throw std::invalid_argument("Invalid character in input string");
+                if (passed[i] == 0)
+                {
+                    continue;
+                }
+                const BigNumber &candidate = survivors[next + i];
+                const MontgomeryContext context(candidate);
+                std::atomic<bool> prime(true);
+                parallelFor(std::max(rounds, 1) - 1, test_cost,
+                            [&context, &candidate, &prime](size_t begin, size_t end)
+                            {
+                                for (size_t round = begin; round < end && prime.load(); ++round)
+                                {
+                                    if (!millerRabinRound(context, randomWitness(candidate)))
+                                    {
+                                        prime = false;
+                                    }
+                                }
+                            });
+                if (prime.load())
+                {
+                    return candidate;
+                }
             }
-            number_digits.push_back(c - '0');
         }
+    }
+}
 
-        trimLeadingZeros();
+// Unsigned fixed width integer of Bits bits (a multiple of 64) with inline limb storage. Arithmetic wraps
+// modulo 2^Bits like the built in unsigned types, and the modular operations work entirely on the stack,
+// so FixedBigNumber<512>, <1024> and <2048> never touch the heap.
+template <size_t Bits>
+class FixedBigNumber
+{
+    static_assert(Bits > 0 && Bits % BigNumber::LIMB_BITS == 0, "FixedBigNumber width must be a multiple of 64 bits");
+
+public:
+    using Limb = BigNumber::Limb;
+    using DoubleLimb = BigNumber::DoubleLimb;
+
+    static constexpr size_t LIMBS = Bits / BigNumber::LIMB_BITS;
+
+    // Zero
+    constexpr FixedBigNumber() : limbs{} {}
+
+    // Constructor from an unsigned 64-bit value
+    constexpr FixedBigNumber(unsigned long long value) : limbs{}
+    {
+        limbs[0] = value;
     }
 
-    // Remove leading zeros from the number
-    void trimLeadingZeros()
+    // Constructor from a decimal literal; usable in constant expressions, where a bad digit or an
+    // overflowing value becomes a compile error
+    constexpr explicit FixedBigNumber(const char *decimal) : limbs{}
     {
-        while (number_digits.size() > 1 && number_digits.back() == 0)
+        for (; *decimal != '\0'; ++decimal)
         {
-            number_digits.pop_back();
+            if (*decimal < '0' || *decimal > '9')
+            {
+                throw std::invalid_argument("Invalid character in input string");
+            }
+            Limb carry = (Limb)(*decimal - '0');
+            unroll([&](size_t i)
+                   {
+                       DoubleLimb product = (DoubleLimb)limbs[i] * 10 + carry;
+                       limbs[i] = (Limb)product;
+                       carry = (Limb)(product >> BigNumber::LIMB_BITS);
+                   });
+            if (carry != 0)
+            {
+                throw std::out_of_range("Value does not fit in FixedBigNumber");
+            }
         }
-        if (number_digits.size() == 1 && number_digits[0] == 0)
+    }
+
+    // Conversion from BigNumber; the value must be non-negative and fit in Bits bits
+    explicit FixedBigNumber(const BigNumber &value) : limbs{}
+    {
+        if (value.isNegative || value.number_limbs.size() > LIMBS)
         {
-            isNegative = false; // Zero is non-negative
+            throw std::out_of_range("Value does not fit in FixedBigNumber");
         }
+        std::copy(value.number_limbs.begin(), value.number_limbs.end(), limbs.begin());
     }
 
-    // absoulte value of the number
-    BigNumber absolute() const
+    // Conversion to BigNumber
+    BigNumber toBigNumber() const
     {
-        BigNumber result = *this;
-        result.isNegative = false;
-        return result;
+        return BigNumber::fromLimbs(limbs.data(), LIMBS);
     }
 
-    // Convert the number to string
+    // Convert the number to a decimal string
     std::string to_string() const
     {
-        // If the BigNum represents zero, return "0"
-        if (number_digits.size() == 1 && number_digits[0] == 0)
-        {
-            return "0";
-        }
+        return toBigNumber().to_string();
+    }
 
-        std::string result;
+    constexpr bool isZero() const
+    {
+        bool zero = true;
+        unroll([&](size_t i) { zero = zero && limbs[i] == 0; });
+        return zero;
+    }
 
-        // Add negative sign if the number is negative
-        if (isNegative)
-        {
-            result += '-';
-        }
+    constexpr bool operator==(const FixedBigNumber &other_number) const
+    {
+        bool equal = true;
+        unroll([&](size_t i) { equal = equal && limbs[i] == other_number.limbs[i]; });
+        return equal;
+    }
 
-        // Iterate through the digits in reverse order
-        for (auto it = number_digits.rbegin(); it != number_digits.rend(); ++it)
-        {
-            result += std::to_string(*it); // Append each digit as a character
-        }
+    constexpr bool operator!=(const FixedBigNumber &other_number) const
+    {
+        return !(*this == other_number);
+    }
+
+    constexpr bool operator<(const FixedBigNumber &other_number) const
+    {
+        return compare(limbs.data(), other_number.limbs.data()) < 0;
+    }
+
+    constexpr bool operator>(const FixedBigNumber &other_number) const
+    {
+        return other_number < *this;
+    }
+
+    constexpr bool operator<=(const FixedBigNumber &other_number) const
+    {
+        return !(*this > other_number);
+    }
+
+    constexpr bool operator>=(const FixedBigNumber &other_number) const
+    {
+        return !(*this < other_number);
+    }
 
+    // Sum modulo 2^Bits
+    constexpr FixedBigNumber operator+(const FixedBigNumber &other_number) const
+    {
+        FixedBigNumber result;
+        add(result.limbs.data(), limbs.data(), other_number.limbs.data());
         return result;
     }
 
-    // overloading == operator
-    bool operator==(const BigNumber &other_number) const
+    // Difference modulo 2^Bits
+    constexpr FixedBigNumber operator-(const FixedBigNumber &other_number) const
     {
-        return number_digits == other_number.number_digits && isNegative == other_number.isNegative;
+        FixedBigNumber result;
+        subtract(result.limbs.data(), limbs.data(), other_number.limbs.data());
+        return result;
     }
 
-    // overloading != operator
-    bool operator!=(const BigNumber &other_number) const
+    // Product modulo 2^Bits
+    constexpr FixedBigNumber operator*(const FixedBigNumber &other_number) const
     {
-        return !(*this == other_number);
+        Limb product[2 * LIMBS] = {};
+        multiply(product, limbs.data(), other_number.limbs.data());
+        FixedBigNumber result;
+        unroll([&](size_t i) { result.limbs[i] = product[i]; });
+        return result;
     }
 
-    // overloading < operator
-    bool operator<(const BigNumber &other_number) const
+    // function for modular addition, reducing the full Bits + 1 bit sum
+    FixedBigNumber modAddition(const FixedBigNumber &other_number, const FixedBigNumber &modulus) const
     {
-        if (isNegative != other_number.isNegative)
-        {
-            return isNegative;
-        }
+        Limb sum[LIMBS + 1];
+        sum[LIMBS] = add(sum, limbs.data(), other_number.limbs.data());
+        return reduce(sum, LIMBS + 1, modulus);
+    }
 
-        if (number_digits.size() != other_number.number_digits.size())
-        {
-            return (isNegative ? number_digits.size() > other_number.number_digits.size() : number_digits.size() < other_number.number_digits.size());
-        }
+    // function for modular multiplication, reducing the full 2 * Bits bit product
+    FixedBigNumber modMultiplication(const FixedBigNumber &other_number, const FixedBigNumber &modulus) const
+    {
+        Limb product[2 * LIMBS];
+        multiply(product, limbs.data(), other_number.limbs.data());
+        return reduce(product, 2 * LIMBS, modulus);
+    }
+
+    // Raw little endian limbs
+    constexpr const Limb *data() const
+    {
+        return limbs.data();
+    }
+
+private:
+    std::array<Limb, LIMBS> limbs;
+
+    // Call f(0), f(1), ..., f(LIMBS - 1) with the loop unrolled at compile time
+    template <typename F>
+    static constexpr void unroll(F &&f)
+    {
+        unrollImpl(f, std::make_index_sequence<LIMBS>());
+    }
+
+    template <typename F, size_t... I>
+    static constexpr void unrollImpl(F &f, std::index_sequence<I...>)
+    {
+        (f(I), ...);
+    }
 
-        for (int i = number_digits.size() - 1; i >= 0; i--)
+    static constexpr int compare(const Limb *a, const Limb *b)
+    {
+        for (size_t i = LIMBS; i-- > 0;)
         {
-            if (number_digits[i] != other_number.number_digits[i])
+            if (a[i] != b[i])
             {
-                return (isNegative ? number_digits[i] > other_number.number_digits[i] : number_digits[i] < other_number.number_digits[i]);
+                return a[i] < b[i] ? -1 : 1;
             }
         }
-
-        return false;
+        return 0;
     }
 
-    // overloading > operator
-    bool operator>(const BigNumber &other_number) const
+    // r = a + b over LIMBS limbs, returning the carry out
+    static constexpr Limb add(Limb *r, const Limb *a, const Limb *b)
     {
-        return other_number < *this;
+        Limb carry = 0;
+        unroll([&](size_t i)
+               {
+                   DoubleLimb sum = (DoubleLimb)a[i] + b[i] + carry;
+                   r[i] = (Limb)sum;
+                   carry = (Limb)(sum >> BigNumber::LIMB_BITS);
+               });
+        return carry;
     }
 
-    // overloading <= operator
-    bool operator<=(const BigNumber &other_number) const
+    // r = a - b over LIMBS limbs, returning the borrow out
+    static constexpr Limb subtract(Limb *r, const Limb *a, const Limb *b)
     {
-        return !(*this > other_number);
+        Limb borrow = 0;
+        unroll([&](size_t i)
+               {
+                   DoubleLimb diff = (DoubleLimb)a[i] - b[i] - borrow;
+                   r[i] = (Limb)diff;
+                   borrow = (Limb)(diff >> BigNumber::LIMB_BITS) & 1;
+               });
+        return borrow;
     }
 
-    // overloading >= operator
-    bool operator>=(const BigNumber &other_number) const
+    // Full 2 * LIMBS product of a and b into r, one unrolled row per limb of a
+    static constexpr void multiply(Limb *r, const Limb *a, const Limb *b)
     {
-        return !(*this < other_number);
+        for (size_t i = 0; i < 2 * LIMBS; ++i)
+        {
+            r[i] = 0;
+        }
+        for (size_t i = 0; i < LIMBS; ++i)
+        {
+            Limb carry = 0;
+            unroll([&](size_t j)
+                   {
+                       DoubleLimb product = (DoubleLimb)a[i] * b[j] + r[i + j] + carry;
+                       r[i + j] = (Limb)product;
+                       carry = (Limb)(product >> BigNumber::LIMB_BITS);
+                   });
+            r[i + LIMBS] = carry;
+        }
     }
 
-    // Helper function to add absolute values of two BigNumbers
-    BigNumber addAbsoluteValues(const BigNumber &a, const BigNumber &b) const
+    // u[0..un) mod modulus, using stack buffers for Knuth division
+    static FixedBigNumber reduce(const Limb *u, size_t un, const FixedBigNumber &modulus)
     {
-        BigNumber result;
-        result.isNegative = false;
-
-        int carry = 0;
-        size_t max_size = std::max(a.number_digits.size(), b.number_digits.size());
-        result.number_digits.clear(); // Clear the result vector
-
-        for (size_t i = 0; i < max_size || carry != 0; ++i)
+        size_t vn = LIMBS;
+        while (vn > 0 && modulus.limbs[vn - 1] == 0)
         {
-            int digit_sum = carry;
-            if (i < a.number_digits.size())
-                digit_sum += a.number_digits[i];
-            if (i < b.number_digits.size())
-                digit_sum += b.number_digits[i];
-
-            result.number_digits.push_back(digit_sum % 10);
-            carry = digit_sum / 10;
+            --vn;
+        }
+        if (vn == 0)
+        {
+            BigNumber::countDivisionByZero();
+            std::cout << "Does not exist" << std::endl;
+            return FixedBigNumber();
+        }
+        while (un > 0 && u[un - 1] == 0)
+        {
+            --un;
         }
 
-        result.trimLeadingZeros();
+        FixedBigNumber result;
+        if (BigNumber::compareLimbs(u, un, modulus.limbs.data(), vn) < 0)
+        {
+            std::copy(u, u + un, result.limbs.begin());
+        }
+        else if (vn == 1)
+        {
+            Limb work[2 * LIMBS];
+            std::copy(u, u + un, work);
+            result.limbs[0] = BigNumber::divLimbsBySingle(work, un, modulus.limbs[0]);
+        }
+        else
+        {
+            Limb scratch[3 * LIMBS + 1];
+            BigNumber::divmodLimbs(nullptr, result.limbs.data(), u, un, modulus.limbs.data(), vn, scratch);
+        }
         return result;
     }
+};
 
-    // Helper function to subtract absolute values of two BigNumbers (a - b) assuming |a| >= |b|
-    BigNumber subtractAbsoluteValues(const BigNumber &a, const BigNumber &b) const
+// Benchmark suite behind ./BigNumber --benchmark. Every operation runs on random operands from a fixed seed at
+// each bit size and reports ns/op, ops/sec, limb allocations per op and the 50th, 90th and 99th percentiles of
+// the per-operation latency. Operations of a microsecond or more are timed one by one; faster ones are timed in
+// the smallest batch that takes about a microsecond, so the clock does not dominate, and their percentiles are of
+// those batch means (ops_per_sample in the JSON). Results can be written to JSON and compared against a saved baseline, in which case any
+// operation that got slower by more than the threshold is flagged and the exit status is 1.
+//
+//   --json FILE        write the results to FILE
+//   --compare FILE     compare against a baseline written by --json
+//   --threshold PCT    slowdown that counts as a regression (default 10)
+//   --seed N           operand seed (default 1)
+//   --min-time MS      measuring time per operation and size (default 200), once MIN_SAMPLES are taken
+//   --max-time MS      cap on the measuring time for slow operations that have not reached MIN_SAMPLES (default 4000)
+//   --bits LIST        comma separated bit sizes (default 256,512,1024,2048,4096,8192)
+//   --operations LIST  comma separated subset of the operations below
+class BigNumberBenchmark
+{
+public:
+    struct Result
     {
-        BigNumber result;
-        result.isNegative = false;
+        std::string operation;
+        size_t bits = 0;
+        double ns_per_op = 0;
+        double ops_per_sec = 0;
+        double allocations_per_op = 0;
+        double p50_ns = 0;
+        double p90_ns = 0;
+        double p99_ns = 0;
+        size_t samples = 0;
+        size_t ops_per_sample = 0;
+        size_t iterations = 0;
+    };
 
-        int borrow = 0;
-        result.number_digits.clear(); // Clear the result vector
+    static const std::vector<std::string> &operations()
+    {
+        static const std::vector<std::string> names = {"from_string", "to_string", "add", "subtract", "multiply",
+                                                       "divide", "modAddition", "modMultiplication", "modInverse",
+                                                       "modPow"};
+        return names;
+    }
 
-        for (size_t i = 0; i < a.number_digits.size(); ++i)
+    // Parse the command line after --benchmark, run and report; returns the process exit status
+    static int run(const std::vector<std::string> &args, std::ostream &log)
+    {
+        try
         {
-            int digit_diff = a.number_digits[i] - borrow;
-            if (i < b.number_digits.size())
+            Options options = parseOptions(args);
+            std::vector<Result> results;
+            log << std::left << std::setw(18) << "operation" << std::right << std::setw(6) << "bits" << std::setw(14)
+                << "ns/op" << std::setw(14) << "ops/sec" << std::setw(10) << "allocs" << std::setw(12) << "p50"
+                << std::setw(12) << "p90" << std::setw(12) << "p99" << std::endl;
+            for (size_t bits : options.bits)
             {
-                digit_diff -= b.number_digits[i];
+                Operands operands(bits, options.seed);
+                for (const std::string &operation : options.operations)
+                {
+                    results.push_back(measure(operation, bits, operands, options.min_time_ns, options.max_time_ns));
+                    print(results.back(), log);
+                }
             }
 
-            if (digit_diff < 0)
+            if (!options.json_path.empty())
             {
-                digit_diff += 10;
-                borrow = 1;
+                std::ofstream out(options.json_path);
+                if (!out)
+                {
+                    throw std::runtime_error("Cannot write " + options.json_path);
+                }
+                writeJson(results, options.seed, out);
             }
-            else
+            if (!options.baseline_path.empty())
             {
-                borrow = 0;
+                return compare(results, readJson(options.baseline_path), options.threshold_percent, log) ? 0 : 1;
             }
+            return 0;
+        }
+        catch (const std::exception &error)
+        {
+            log << "benchmark: " << error.what() << std::endl;
+            return 2;
+        }
+    }
 
-            result.number_digits.push_back(digit_diff);
+    static void writeJson(const std::vector<Result> &results, uint64_t seed, std::ostream &out)
+    {
+        out << "{\n  \"seed\": " << seed << ",\n  \"kernel\": \""
+            << BigNumber::limbKernelName(BigNumber::limbKernel()) << "\",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"operation\": \"" << r.operation << "\", \"bits\": " << r.bits
+                << std::fixed << std::setprecision(3) << ", \"ns_per_op\": " << r.ns_per_op
+                << ", \"ops_per_sec\": " << r.ops_per_sec << ", \"allocations_per_op\": " << r.allocations_per_op
+                << ", \"p50_ns\": " << r.p50_ns << ", \"p90_ns\": " << r.p90_ns << ", \"p99_ns\": " << r.p99_ns
+                << std::defaultfloat << ", \"samples\": " << r.samples << ", \"ops_per_sample\": " << r.ops_per_sample
+                << ", \"iterations\": " << r.iterations
+                << "}";
         }
+        out << "\n  ]\n}\n";
+    }
 
-        result.trimLeadingZeros();
-        return result;
+    // Results from a file written by writeJson. Only the flat result objects are read, so this is not a
+    // general JSON parser.
+    static std::vector<Result> readJson(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            throw std::runtime_error("Cannot read " + path);
+        }
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        std::vector<Result> results;
+        for (size_t start = text.find("{\"operation\""); start != std::string::npos;
+             start = text.find("{\"operation\"", start + 1))
+        {
+            const std::string object = text.substr(start, text.find('}', start) - start);
+            Result r;
+            r.operation = stringField(object, "operation");
+            r.bits = (size_t)numberField(object, "bits");
+            r.ns_per_op = numberField(object, "ns_per_op");
+            r.ops_per_sec = numberField(object, "ops_per_sec");
+            r.allocations_per_op = numberField(object, "allocations_per_op");
+            r.p50_ns = numberField(object, "p50_ns");
+            r.p90_ns = numberField(object, "p90_ns");
+            r.p99_ns = numberField(object, "p99_ns");
+            r.samples = (size_t)numberField(object, "samples");
+            r.ops_per_sample = (size_t)numberField(object, "ops_per_sample");
+            r.iterations = (size_t)numberField(object, "iterations");
+            results.push_back(r);
+        }
+        return results;
     }
 
-    // Overload the + operator for BigNumber
-    BigNumber operator+(const BigNumber &other_number) const
+    // Print the change against the baseline for every operation both runs measured; returns false when any of
+    // them got slower by more than threshold_percent
+    static bool compare(const std::vector<Result> &results, const std::vector<Result> &baseline,
+                        double threshold_percent, std::ostream &log)
     {
-        if (isNegative == other_number.isNegative)
+        size_t regressions = 0;
+        log << std::endl << std::left << std::setw(18) << "operation" << std::right << std::setw(6) << "bits"
+            << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change" << std::endl;
+        for (const Result &r : results)
         {
-            // If both numbers have the same sign, add their absolute values
-            BigNumber result = addAbsoluteValues(*this, other_number);
-            result.isNegative = isNegative; // The result will have the same sign as both numbers
-            return result;
+            const auto match = std::find_if(baseline.begin(), baseline.end(), [&](const Result &b) {
+                return b.operation == r.operation && b.bits == r.bits;
+            });
+            if (match == baseline.end() || match->ns_per_op <= 0)
+            {
+                continue;
+            }
+
+            const double change = (r.ns_per_op / match->ns_per_op - 1) * 100;
+            const bool regression = change > threshold_percent;
+            regressions += regression;
+            log << std::left << std::setw(18) << r.operation << std::right << std::setw(6) << r.bits << std::fixed
+                << std::setprecision(1) << std::setw(14) << match->ns_per_op << std::setw(14) << r.ns_per_op
+                << std::showpos << std::setw(9) << change << "%" << std::noshowpos << std::defaultfloat
+                << (regression ? "  REGRESSION" : change < -threshold_percent ? "  improved" : "") << std::endl;
         }
-        else
+        // The rows above leave a one digit precision on the stream, so format the threshold on its own
+        std::ostringstream threshold;
+        threshold << threshold_percent;
+        log << regressions << " regression(s) above " << threshold.str() << "%" << std::endl;
+        return regressions == 0;
+    }
+
+private:
+    // Distinct operand sets cycled through, so one cached value does not flatter the timings
+    static constexpr size_t OPERAND_SETS = 16;
+
+    // Samples per measurement: enough for a p99 with a sample above it, unless max_time runs out first
+    static constexpr size_t MIN_SAMPLES = 200;
+    static constexpr size_t MAX_SAMPLES = size_t(1) << 20;
+
+    // Shortest sample worth timing; faster operations are batched up to this
+    static constexpr double SAMPLE_NS = 1000;
+
+    struct Options
+    {
+        std::string json_path;
+        std::string baseline_path;
+        double threshold_percent = 10;
+        uint64_t seed = 1;
+        double min_time_ns = 200e6;
+        double max_time_ns = 4000e6;
+        std::vector<size_t> bits = {256, 512, 1024, 2048, 4096, 8192};
+        std::vector<std::string> operations = BigNumberBenchmark::operations();
+    };
+
+    // Random operands for one bit size: a and b below an odd modulus m of exactly that size, a invertible mod m,
+    // their decimal strings, an exponent of the same size and a dividend of twice the size
+    struct Operands
+    {
+        BigNumber modulus;
+        std::vector<BigNumber> a, b, exponent, dividend;
+        std::vector<std::string> decimal;
+
+        Operands(size_t bits, uint64_t seed)
+        {
+            std::mt19937_64 generator(seed * 1000003 + bits);
+            modulus = random(bits, generator, true);
+            for (size_t i = 0; i < OPERAND_SETS; ++i)
+            {
+                BigNumber x = random(bits, generator, false) % modulus;
+                while (!invertible(x, modulus))
+                {
+                    x = random(bits, generator, false) % modulus;
+                }
+                a.push_back(x);
+                b.push_back(random(bits, generator, false) % modulus);
+                exponent.push_back(random(bits, generator, false));
+                dividend.push_back(random(2 * bits, generator, false));
+                decimal.push_back(x.to_string());
+            }
+        }
+
+        static bool invertible(const BigNumber &x, const BigNumber &modulus)
+        {
+            try
+            {
+                x.modInverse(modulus);
+                return true;
+            }
+            catch (const std::invalid_argument &)
+            {
+                return false;
+            }
+        }
+
+        // A value of exactly bits bits, odd when asked
+        static BigNumber random(size_t bits, std::mt19937_64 &generator, bool odd)
+        {
+            std::string hex;
+            for (size_t i = 0; i < (bits + 3) / 4; ++i)
+            {
+                hex += "0123456789abcdef"[generator() & 15];
+            }
+            hex[0] = "89abcdef"[generator() & 7];
+            if (odd)
+            {
+                hex.back() = "13579bdf"[generator() & 7];
+            }
+            return BigNumber::fromHex(hex);
+        }
+    };
+
+    static Options parseOptions(const std::vector<std::string> &args)
+    {
+        Options options;
+        for (size_t i = 0; i < args.size(); ++i)
         {
-            // If the signs are different, subtract the smaller absolute value from the larger
-            if (absolute() >= other_number.absolute())
+            const std::string &flag = args[i];
+            if (i + 1 >= args.size())
+            {
+                throw std::invalid_argument("Missing value for " + flag);
+            }
+            const std::string &value = args[++i];
+            if (flag == "--json")
+            {
+                options.json_path = value;
+            }
+            else if (flag == "--compare")
+            {
+                options.baseline_path = value;
+            }
+            else if (flag == "--threshold")
+            {
+                options.threshold_percent = std::stod(value);
+            }
+            else if (flag == "--seed")
+            {
+                options.seed = std::stoull(value);
+            }
+            else if (flag == "--min-time")
+            {
+                options.min_time_ns = std::stod(value) * 1e6;
+            }
+            else if (flag == "--max-time")
+            {
+                options.max_time_ns = std::stod(value) * 1e6;
+            }
+            else if (flag == "--bits")
+            {
+                options.bits.clear();
+                for (const std::string &item : splitList(value))
+                {
+                    const size_t bits = std::stoul(item);
+                    if (bits < 8)
+                    {
+                        throw std::invalid_argument("Bit sizes must be at least 8");
+                    }
+                    options.bits.push_back(bits);
+                }
+            }
+            else if (flag == "--operations")
             {
-                BigNumber result = subtractAbsoluteValues(*this, other_number);
-                result.isNegative = isNegative; // Keep the sign of the larger absolute value
-                return result;
+                options.operations = splitList(value);
+                for (const std::string &operation : options.operations)
+                {
+                    if (std::find(operations().begin(), operations().end(), operation) == operations().end())
+                    {
+                        throw std::invalid_argument("Unknown operation " + operation);
+                    }
+                }
             }
             else
             {
-                BigNumber result = subtractAbsoluteValues(other_number, *this);
-                result.isNegative = other_number.isNegative; // Keep the sign of the larger absolute value
-                return result;
+                throw std::invalid_argument("Unknown option " + flag);
             }
         }
+        return options;
     }
 
-    // Overload the - operator for BigNumber
-    BigNumber operator-(const BigNumber &other_number) const
-    {
-        // Subtraction is addition with the opposite sign
-        BigNumber negated_other = other_number;
-        negated_other.isNegative = !other_number.isNegative; // Flip the sign
-        return *this + negated_other;
-    }
-
-    // Overload the * operator for BigNumber
-    BigNumber operator*(const BigNumber &other_number) const
+    static std::vector<std::string> splitList(const std::string &list)
     {
-        BigNumber result;
-        result.number_digits.resize(number_digits.size() + other_number.number_digits.size(), 0); // Clear the result vector
-        result.isNegative = (isNegative != other_number.isNegative); // The sign of the result is negative if the signs are different
-
-        // Multiply the absolute values of the two numbers
-        for (size_t i = 0; i < number_digits.size(); ++i)
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
         {
-            for (size_t j = 0; j < other_number.number_digits.size(); ++j)
+            if (!item.empty())
             {
-                int product = number_digits[i] * other_number.number_digits[j];
-                int position = i + j;
-                while (product > 0)
-                {
-                    if (position == result.number_digits.size())
-                    {
-                        result.number_digits.push_back(0);
-                    }
-                    product += result.number_digits[position];
-                    result.number_digits[position] = product % 10;
-                    product /= 10;
-                    position++;
-                }
+                items.push_back(item);
             }
         }
-
-        result.trimLeadingZeros();
-        return result;
+        return items;
     }
 
-    // Overload the % operator for BigNumber (modulus operation)
-    BigNumber operator%(const BigNumber &other_number) const
+    // Run operation i on operand set i % OPERAND_SETS, folding something from the result into sink so the work
+    // cannot be optimized away
+    static size_t runOnce(const std::string &operation, Operands &o, size_t i)
     {
-        // Perform division and return the remainder
-        return divide(other_number).second;
+        const size_t k = i % OPERAND_SETS;
+        const size_t j = (i + 1) % OPERAND_SETS;
+        if (operation == "from_string")
+        {
+            return BigNumber(o.decimal[k]).bitLength();
+        }
+        if (operation == "to_string")
+        {
+            return o.a[k].to_string().size();
+        }
+        if (operation == "add")
+        {
+            return (o.a[k] + o.b[j]).bitLength();
+        }
+        if (operation == "subtract")
+        {
+            return (o.a[k] - o.b[j]).bitLength();
+        }
+        if (operation == "multiply")
+        {
+            return (o.a[k] * o.b[j]).bitLength();
+        }
+        if (operation == "divide")
+        {
+            return o.dividend[k].divide(o.b[j]).second.bitLength();
+        }
+        if (operation == "modAddition")
+        {
+            return o.a[k].modAddition(o.b[j], o.modulus).bitLength();
+        }
+        if (operation == "modMultiplication")
+        {
+            return o.a[k].modMultiplication(o.b[j], o.modulus).bitLength();
+        }
+        if (operation == "modInverse")
+        {
+            return o.a[k].modInverse(o.modulus).bitLength();
+        }
+        return o.a[k].modPow(o.exponent[j], o.modulus).bitLength();
     }
 
-    // Overload the / operator for BigNumber
-    BigNumber operator/(const BigNumber &other_number) const
+    // Time samples of one operation, or of the smallest batch that reaches SAMPLE_NS, until there are
+    // MIN_SAMPLES of them and min_time has passed, or max_time has. A warm-up pass over the operand sets,
+    // untimed, sizes the batch.
+    static Result measure(const std::string &operation, size_t bits, Operands &operands, double min_time_ns,
+                          double max_time_ns)
     {
-        // Perform division and return the quotient
-        return divide(other_number).first;
-    }
+        using Clock = std::chrono::steady_clock;
+        size_t sink = 0;
+        size_t next = 0;
 
-    // Helper function to divide two BigNumbers
-    std::pair<BigNumber, BigNumber> divide(const BigNumber &other_number) const
-    {
-        if (other_number == BigNumber("0"))
+        double warm_ns = 0;
+        size_t warm_ops = 0;
+        while (warm_ops < OPERAND_SETS && (warm_ops == 0 || warm_ns < min_time_ns / 10))
         {
-            // throw std::invalid_argument("Division by zero");
-            std::cout << "Does not exist" << std::endl;
-            return {BigNumber("0"), BigNumber("0")};
+            const auto start = Clock::now();
+            sink += runOnce(operation, operands, next++);
+            warm_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            ++warm_ops;
         }
+        const double single_ns = std::max(1.0, warm_ns / warm_ops);
+        const size_t batch = std::max<size_t>(1, (size_t)std::ceil(SAMPLE_NS / single_ns));
 
-        BigNumber result, remainder;
-        result.number_digits.resize(number_digits.size(), 0);
-        result.isNegative = isNegative != other_number.isNegative;
-        remainder.isNegative = isNegative;
-
-        for (int i = number_digits.size() - 1; i >= 0; --i)
+        std::vector<double> sample_ns;
+        double total_ns = 0;
+        BigNumber::AllocationCounter allocations;
+        while (sample_ns.size() < MAX_SAMPLES && total_ns < max_time_ns &&
+               (sample_ns.size() < MIN_SAMPLES || total_ns < min_time_ns))
         {
-            remainder.number_digits.insert(remainder.number_digits.begin(), number_digits[i]);
-            remainder.trimLeadingZeros();
-
-            int quotientDigit = 0;
-            int left = 0, right = 10;
-            while (left <= right)
+            const auto start = Clock::now();
+            for (size_t i = 0; i < batch; ++i)
             {
-                int mid = (left + right) / 2;
-                BigNumber candidate = other_number.absolute() * BigNumber(mid);
-                if (candidate <= remainder.absolute())
-                {
-                    quotientDigit = mid;
-                    left = mid + 1;
-                }
-                else
-                {
-                    right = mid - 1;
-                }
+                sink += runOnce(operation, operands, next++);
             }
+            const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            total_ns += elapsed;
+            sample_ns.push_back(elapsed / batch);
+        }
+        const size_t allocation_count = allocations.allocations();
 
-            BigNumber product = other_number.absolute() * BigNumber(quotientDigit);
-            remainder = remainder - product;
+        Result result;
+        result.operation = operation;
+        result.bits = bits;
+        result.samples = sample_ns.size();
+        result.ops_per_sample = batch;
+        result.iterations = sample_ns.size() * batch;
+        result.ns_per_op = total_ns / result.iterations;
+        result.ops_per_sec = 1e9 / result.ns_per_op;
+        result.allocations_per_op = (double)allocation_count / result.iterations;
+        std::sort(sample_ns.begin(), sample_ns.end());
+        result.p50_ns = percentile(sample_ns, 50);
+        result.p90_ns = percentile(sample_ns, 90);
+        result.p99_ns = percentile(sample_ns, 99);
 
-            result.number_digits.insert(result.number_digits.begin(), quotientDigit);
+        // The sink is never zero in practice; the check keeps it live
+        if (sink == 0)
+        {
+            result.operation += " (no result)";
         }
-
-        result.trimLeadingZeros();
-        remainder.trimLeadingZeros();
-        return {result, remainder};
+        return result;
     }
 
-    // Overload the unary - operator for BigNumber
-    BigNumber operator-() const
+    // Nearest rank percentile of sorted values
+    static double percentile(const std::vector<double> &sorted, double percent)
     {
-        BigNumber result = *this;
-        result.isNegative = !isNegative;
-        return result;
+        const size_t rank = (size_t)std::ceil(percent / 100 * sorted.size());
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
     }
 
-    // function for modalar addition
-    BigNumber modAddition(const BigNumber &other_number, const BigNumber &modulus)
+    static void print(const Result &r, std::ostream &log)
     {
-        BigNumber result = *this + other_number;
-        return result % modulus;
+        log << std::left << std::setw(18) << r.operation << std::right << std::setw(6) << r.bits << std::fixed
+            << std::setprecision(1) << std::setw(14) << r.ns_per_op << std::setprecision(0) << std::setw(14)
+            << r.ops_per_sec << std::setprecision(2) << std::setw(10) << r.allocations_per_op << std::setprecision(1)
+            << std::setw(12) << r.p50_ns << std::setw(12) << r.p90_ns << std::setw(12) << r.p99_ns
+            << std::defaultfloat << std::endl;
     }
 
-    // fuction for modular multiplication
-    BigNumber modMultiplication(const BigNumber &other_number, const BigNumber &modulus)
+    static std::string stringField(const std::string &object, const std::string &key)
     {
-        BigNumber result = *this * other_number;
-        return result % modulus;
+        const size_t colon = object.find(':', object.find("\"" + key + "\""));
+        const size_t open = object.find('"', colon);
+        return object.substr(open + 1, object.find('"', open + 1) - open - 1);
     }
 
-    BigNumber modInverse(const BigNumber &modulus)
+    static double numberField(const std::string &object, const std::string &key)
     {
-        BigNumber a = *this;
-        BigNumber m = modulus;
-        BigNumber m0 = m;
-        BigNumber t, q;
-        BigNumber x0 = 0, x1 = 1;
-
-        if (m == 1)
-            return 0;
-
-        // Apply extended Euclid Algorithm
-        while (a > 1)
+        const size_t at = object.find("\"" + key + "\"");
+        if (at == std::string::npos)
         {
-            // q is quotient
-            q = a / m;
-
-            t = m;
-
-            // m is remainder now, process same as Euclid's algo
-            m = a % m, a = t;
-
-            t = x0;
-
-            x0 = x1 - q * x0;
-
-            x1 = t;
+            return 0;
         }
-
-        // Make x1 positive
-        if (x1 < 0)
-            x1 = x1 + m0;
-
-        return x1;
+        return std::strtod(object.c_str() + object.find(':', at) + 1, nullptr);
     }
 };
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Measure the multiplication crossover points for this machine instead of running the test cases
+    if (argc > 1 && std::string(argv[1]) == "--tune-multiplication")
+    {
+        BigNumber::tuneMultiplicationThresholds(std::cout);
+        return 0;
+    }
+
+    // Benchmark the arithmetic instead of running the test cases, see BigNumberBenchmark for the options
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        return BigNumberBenchmark::run(std::vector<std::string>(argv + 2, argv + argc), std::cout);
+    }
+
     
     BigNumber num0("0");
     BigNumber num1("7411983660145561438669578801503455163517312471829001959053178951383381181774990719242089448703004658285326780366787478508242288148487675488967829478156097");
@@ -451,6 +6585,9 @@ int main()
     BigNumber mod_1024("179769313486231590772930519078902473361797697894230657273430081157732675805500963132708477322407536021120113879871393357658789768814416622492847430639474124377767893424865485276302219601246094119453082952085005768838150682342462881473913110540827237163350510684586298239947245938479716304835356329624224137216");
     BigNumber mod_2048("32317006071311007300714876688669951960444102669715484032130345427524655138867890893197201411522913463688717960921898019494119559150490921095088152386448283120630877367300996091750197750389652106796057638384067568276792218642619756161838094338476170470581645852036305042887575891541065808607552399123930385521914333389668342420684974786564569494856176035326322058077805659331026192708460314150258592864177116725943603718461857357598351152301645904403697613233287231227125684710820209725157101726931323469678542580656697935045997268352998638215525166389437335543602135433229604645318478604952148193555853611059596230656");
 
+    BigNumber mod_512_odd("13407807929942597099574024998205846127479365820592393377723561443721764030073546976801874298166903427690031858186486050853753882811946569946433649006083527");
+    BigNumber mod_2048_odd("32317006071311007300714876688669951960444102669715484032130345427524655138867890893197201411522913463688717960921898019494119559150490921095088152386448283120630877367300996091750197750389652106796057638384067568276792218642619756161838094338476170470581645852036305042887575891541065808607552399123930385521914333389668342420684974786564569494856176035326322058077805659331026192708460314150258592864177116725943603718461857357598351152301645904403697613233287231227125684710820209725157101726931323469678542580656697935045997268352998638215525166389437335543602135433229604645318478604952148193555853611059594288367");
+
     // Addtion test cases
     
     std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
@@ -544,6 +6681,196 @@ int main()
     std::cout << "Calculated    : " << product5.to_string() << std::endl;
     std::cout << "Expected      : 152642452731986236266917600130708390579028167712776439390699028344909777667204382863740435807987428154387474465444171074509230880947785368936452777958972785382354187915618459205899645333281563009066484139615965359723310359933667317792118326106773678447759884378243046264543382049899602593075709467366738045073" << std::endl;
 
+    // Montgomery multiplication test cases
+
+    MontgomeryContext context_512(mod_512_odd);
+    MontgomeryContext context_2048(mod_2048_odd);
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num2.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (Montgomery)" << std::endl;
+    BigNumber product6 = num1.modMultiplication(num2, context_512);
+    std::cout << "Calculated    : " << product6.to_string() << std::endl;
+    std::cout << "Expected      : 3859642813058405983201022675020866051792793319792614245822492620773412475351238740256691807443025984710366397692588509195842009618802443272066518991003118" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd (Montgomery)" << std::endl;
+    BigNumber product7 = num5.modMultiplication(num6, context_2048);
+    std::cout << "Calculated    : " << product7.to_string() << std::endl;
+    std::cout << "Expected      : 384237580719514610744886063626338323282105856922275785699710245347396431414551768736293749775457619741358646230539111660048105903971869864149160327406542018031094270725083890262952068473679211782263812963526495173094918879147190762206139194587393403232901181446234064656339279111064713578560148124974104653480398375099351830901172990775962923084166959329596416379424699367893233440432600183104893423075251470513905603700507467814397691962298818012559765596534956756037789040930183772166782297120718317704501427188338925381223335592730201502144398717107835775350410899809428249512879581098942538623975932259756226750" << std::endl;
+
+    // Reducer test cases
+
+    Reducer reducer_2048_odd(mod_2048_odd);
+    Reducer reducer_2048_even(num6);
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd (pseudo-Mersenne reducer)" << std::endl;
+    BigNumber sum7 = num5.modAddition(num6, reducer_2048_odd);
+    std::cout << "Calculated    : " << sum7.to_string() << std::endl;
+    std::cout << "Expected      : 14786083589454066911684569384169285651094143353342886096143124860765766376128253707950850701992513140527741208967826128290489348582836884023423747337808290210764107653896595806004008890620774140954765635163695625232209380358980861970067216554299326508242642366142528936046951499407576529205579957343659431256735533054957931116166001236800019175216794081777041095284819885955181737238923203286180142373670494654196052550701380525489369685992441723131944112903524657528820682556344443590191199099577988614678180425972198363668839854212299101028406451292368332405544230517777937373563534753698059149209411298402978791367" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd (pseudo-Mersenne reducer)" << std::endl;
+    BigNumber product8 = num5.modMultiplication(num6, reducer_2048_odd);
+    std::cout << "Calculated    : " << product8.to_string() << std::endl;
+    std::cout << "Expected      : 384237580719514610744886063626338323282105856922275785699710245347396431414551768736293749775457619741358646230539111660048105903971869864149160327406542018031094270725083890262952068473679211782263812963526495173094918879147190762206139194587393403232901181446234064656339279111064713578560148124974104653480398375099351830901172990775962923084166959329596416379424699367893233440432600183104893423075251470513905603700507467814397691962298818012559765596534956756037789040930183772166782297120718317704501427188338925381223335592730201502144398717107835775350410899809428249512879581098942538623975932259756226750" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num3.to_string() << std::endl;
+    std::cout << "modulus : Number 6, 2048bits even (Barrett reducer)" << std::endl;
+    BigNumber product9 = num5.modMultiplication(num3, reducer_2048_even);
+    std::cout << "Calculated    : " << product9.to_string() << std::endl;
+    std::cout << "Expected      : 782587064969636596290821377149715169231357222545469257112162280044250509720349254575830713263894839247662640327946586642436030269166151949631755000809807387223469385878090391466081426706815626022448672056588521977171838711723419839601405832206565281270462447854785012249899034151672915835392117672927761850261503144830618561170356961311038142744783101538717979747190901029006055414186329835225146175647871302664555472807582359198985957918057079757151224518971880986401591482811757032760549218177815403897373130528889351284412877357184471696610778128372460492694075040319511606586803038053932486709731425503077629327" << std::endl;
+
+    // Lazy expression test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num2.to_string() << std::endl;
+    std::cout << "Number 3: " << num0.to_string() << std::endl;
+    std::cout << "modulus : 512bits, (Number 1 * Number 2 + Number 3) % modulus (lazy)" << std::endl;
+    BigNumber fused1 = (BigNumber::lazy(num1) * num2 + num0) % mod_512;
+    std::cout << "Calculated    : " << fused1.to_string() << std::endl;
+    std::cout << "Expected      : 12515075797697995846956240208764939695950768703025659807810571944662006202778458249170429605928138870908686307763974182923128121001274469827172323354282589" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num3.to_string() << std::endl;
+    std::cout << "Number 3: " << num4.to_string() << std::endl;
+    std::cout << "modulus : 2048bits even, (Number 1 * Number 2 + Number 3) % modulus (lazy, Barrett reducer)" << std::endl;
+    BigNumber fused2 = (BigNumber::lazy(num5) * num3 + num4) % reducer_2048_even;
+    std::cout << "Calculated    : " << fused2.to_string() << std::endl;
+    std::cout << "Expected      : 782587064969636596290821377149715169231357222545469257112162280044250509720349254575830713263894839247662640327946586642436030269166151949631755000809807387223469385878090391466081426706815626022448672056588521977171838711723419839601405832206565281270462447854785012249899034151672915835392117672927761850349101394866664889531930940816935722532239810637892728895614155870101401580259046159598839576937677343014481406169706769677408601218395543104641313714884563096920572049262793393613426576574355688465820534598818286549740870764555048581273510061270257341762279235908452459238714464350068168874372916869654989364" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd, (Number 1 * Number 2) % modulus (lazy, Montgomery)" << std::endl;
+    BigNumber fused3 = (BigNumber::lazy(num5) * num6) % context_2048;
+    std::cout << "Calculated    : " << fused3.to_string() << std::endl;
+    std::cout << "Expected      : 384237580719514610744886063626338323282105856922275785699710245347396431414551768736293749775457619741358646230539111660048105903971869864149160327406542018031094270725083890262952068473679211782263812963526495173094918879147190762206139194587393403232901181446234064656339279111064713578560148124974104653480398375099351830901172990775962923084166959329596416379424699367893233440432600183104893423075251470513905603700507467814397691962298818012559765596534956756037789040930183772166782297120718317704501427188338925381223335592730201502144398717107835775350410899809428249512879581098942538623975932259756226750" << std::endl;
+
+    // Exponentiation test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num2.to_string() << std::endl;
+    std::cout << "modulus : 512bits" << std::endl;
+    BigNumber power1 = num1.modPow(num2, mod_512);
+    std::cout << "Calculated    : " << power1.to_string() << std::endl;
+    std::cout << "Expected      : 598767738473318367308252863778331795028466753116760701607223324629972417976465031500936980824012883181927831495221277342085740230745494923658608245232193" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num3.to_string() << std::endl;
+    std::cout << "Number 2: " << num4.to_string() << std::endl;
+    std::cout << "modulus : 1024bits" << std::endl;
+    BigNumber power2 = num3.modPow(num4, mod_1024);
+    std::cout << "Calculated    : " << power2.to_string() << std::endl;
+    std::cout << "Expected      : 68008462947561998064542510334556861782995804499959838940717260629371003100879855726084748778223205079652539404432690543137258480997015559977155803497215333709474190114030890080926252777451782909609781750195252423295887061774952506154407392111180155267263187757136252146896519083320330978526628607868763989005" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num2.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (Montgomery)" << std::endl;
+    BigNumber power3 = num1.modPow(num2, context_512);
+    std::cout << "Calculated    : " << power3.to_string() << std::endl;
+    std::cout << "Expected      : 3813839247499989001200077190149932524357506651486704635134267964375474714014177406264922351866177407327399335689156258448556379989723284007569988214792664" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "Number 2: " << num6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd (Montgomery)" << std::endl;
+    BigNumber power4 = num5.modPow(num6, context_2048);
+    std::cout << "Calculated    : " << power4.to_string() << std::endl;
+    std::cout << "Expected      : 22019507993443689416319225325566240107030582466773597467213782055315794671442106321650324242598882542941185589014574199889921399125536730302092087797426891870492455434122025888415333691774419245404304212166705679856790724827112932745139114662034828945314955984000223803735790852545177538350117130714613800329580852938302402076967562148119787350033422322846216651582117476873655505216829961518934850828367430951943575006746168490858089322865405333538917315600736691297951406697739016772427674768087845451651960013039454593650387668257232602931997115275813353618789741944001934312616339533653329194959249820612703159529" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << " ^ " << num2.to_string() << std::endl;
+    std::cout << "Number 2: " << num12.to_string() << " ^ " << num11.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (simultaneous)" << std::endl;
+    BigNumber multi_power1 = BigNumber::multiModPow({num1, num12}, {num2, num11}, mod_512_odd);
+    std::cout << "Calculated    : " << multi_power1.to_string() << std::endl;
+    std::cout << "Expected      : 9874314761208815521781410113414987612127709052318636668217077307624678693528649520002340305330405792091456562198892286385735112455405261143648631168778019" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << " ^ " << num2.to_string() << std::endl;
+    std::cout << "Number 2: " << num12.to_string() << " ^ " << num11.to_string() << std::endl;
+    std::cout << "modulus : 512bits (simultaneous)" << std::endl;
+    BigNumber multi_power2 = BigNumber::multiModPow({num1, num12}, {num2, num11}, mod_512);
+    std::cout << "Calculated    : " << multi_power2.to_string() << std::endl;
+    std::cout << "Expected      : 6749161870949723522432852337822382399565725899663194102478607180643462545610228127051863835112756278918328550040399402429672684228515630657954797075578561" << std::endl;
+
+    // Fixed width test cases
+
+    constexpr FixedBigNumber<512> fixed_one("1");
+    FixedBigNumber<512> fixed1(num1), fixed2(num2), fixed_mod_512(mod_512_odd);
+    FixedBigNumber<2048> fixed5(num5), fixed6(num6), fixed_mod_2048(mod_2048_odd);
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << fixed1.to_string() << std::endl;
+    std::cout << "Number 2: " << fixed2.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (fixed width)" << std::endl;
+    FixedBigNumber<512> fixed_sum1 = fixed1.modAddition(fixed2, fixed_mod_512);
+    std::cout << "Calculated    : " << fixed_sum1.to_string() << std::endl;
+    std::cout << "Expected      : 796728662396498536339659142555595557536320995059312995756140781045768548419561475197690931397406591388460882444330637427724063319412847898968999671677335" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << fixed1.to_string() << std::endl;
+    std::cout << "Number 2: " << fixed_one.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (fixed width)" << std::endl;
+    FixedBigNumber<512> fixed_product1 = fixed1.modMultiplication(fixed_one, fixed_mod_512);
+    std::cout << "Calculated    : " << fixed_product1.to_string() << std::endl;
+    std::cout << "Expected      : 7411983660145561438669578801503455163517312471829001959053178951383381181774990719242089448703004658285326780366787478508242288148487675488967829478156097" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << fixed1.to_string() << std::endl;
+    std::cout << "Number 2: " << fixed2.to_string() << std::endl;
+    std::cout << "modulus : 512bits odd (fixed width)" << std::endl;
+    FixedBigNumber<512> fixed_product2 = fixed1.modMultiplication(fixed2, fixed_mod_512);
+    std::cout << "Calculated    : " << fixed_product2.to_string() << std::endl;
+    std::cout << "Expected      : 3859642813058405983201022675020866051792793319792614245822492620773412475351238740256691807443025984710366397692588509195842009618802443272066518991003118" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << fixed5.to_string() << std::endl;
+    std::cout << "Number 2: " << fixed6.to_string() << std::endl;
+    std::cout << "modulus : 2048bits odd (fixed width)" << std::endl;
+    FixedBigNumber<2048> fixed_product3 = fixed5.modMultiplication(fixed6, fixed_mod_2048);
+    std::cout << "Calculated    : " << fixed_product3.to_string() << std::endl;
+    std::cout << "Expected      : 384237580719514610744886063626338323282105856922275785699710245347396431414551768736293749775457619741358646230539111660048105903971869864149160327406542018031094270725083890262952068473679211782263812963526495173094918879147190762206139194587393403232901181446234064656339279111064713578560148124974104653480398375099351830901172990775962923084166959329596416379424699367893233440432600183104893423075251470513905603700507467814397691962298818012559765596534956756037789040930183772166782297120718317704501427188338925381223335592730201502144398717107835775350410899809428249512879581098942538623975932259756226750" << std::endl;
+
+    // Conversion test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Calculated    : " << num1.to_hex() << std::endl;
+    std::cout << "Expected      : 8d85057e0a45c6507ff90c1c2f0dc9654975193004114d1dce35536a1cfb73653d4a4131c70ef6c58ef4d0527d397aee283946fe97d2b539b49a2951e9afa741" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num8.to_string() << std::endl;
+    BigNumber hex_round_trip = BigNumber::fromHex(num8.to_hex());
+    std::cout << "Calculated    : " << hex_round_trip.to_string() << std::endl;
+    std::cout << "Expected      : -6336461024454555932117034620426269405603205053829332619775501312678451912302336981110491969510120496437848174308143936942302152441755195312221302326928296671425622870962436283222537438995495994212112578469660192949932564280680664177812760498539627014299285708707719544379308855587018396967627039218836334123966973818724993636175084927568049941779992422611228286435776384882043784788594220553355992607686030148563073894634656307367612729620597238212220728445628077696393146609689625215720572867360334177879067717950179312553546441650724578725404169330430981346873295541384523278548267474572352974723334945650111500043" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    BigNumber bytes_round_trip = BigNumber::fromBytes(num5.toBytes(BigNumber::ByteOrder::LittleEndian), BigNumber::ByteOrder::LittleEndian);
+    std::cout << "Calculated    : " << bytes_round_trip.to_string() << std::endl;
+    std::cout << "Expected      : 6336461024454555932117034620426269405603205053829332619775501312678451912302336981110491969510120496437848174308143936942302152441755195312221302326928296671425622870962436283222537438995495994212112578469660192949932564280680664177812760498539627014299285708707719544379308855587018396967627039218836334123966973818724993636175084927568049941779992422611228286435776384882043784788594220553355992607686030148563073894634656307367612729620597238212220728445628077696393146609689625215720572867360334177879067717950179312553546441650724578725404169330430981346873295541384523278548267474572352974723334945650111500043" << std::endl;
+
     // Inverse test cases
 
     std::cout << "===========================================================================================" << std::endl;
@@ -578,7 +6905,257 @@ int main()
     std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
     std::cout << "Number 1: " << num11.to_string() << std::endl;
     std::cout << "modulus : 512bits" << std::endl;
-    BigNumber inverse5 = num11.modInverse(mod_512);
+    try
+    {
+        BigNumber inverse5 = num11.modInverse(mod_512);
+        std::cout << "Calculated    : " << inverse5.to_string() << std::endl;
+    }
+    catch (const std::invalid_argument &)
+    {
+        std::cout << "Calculated    : Does not exist" << std::endl;
+    }
+    std::cout << "Expected      : Does not exist" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Batch   : num1, num0, num2" << std::endl;
+    std::cout << "modulus : 512bits" << std::endl;
+    std::vector<BigNumber> batch = {num1, num0, num2};
+    size_t batch_failures = BigNumber::batchModInverse(batch, mod_512);
+    std::cout << "Calculated    : " << batch_failures << std::endl;
+    std::cout << "Expected      : 1" << std::endl;
+    std::cout << "Calculated    : " << batch[0].to_string() << std::endl;
+    std::cout << "Expected      : 9147482900272338539705261019175300624143989181826741864596824711264600130384856868068663746785895787813079850763254056636409668114587263601063751447537857" << std::endl;
+    std::cout << "Calculated    : " << batch[1].to_string() << std::endl;
+    std::cout << "Expected      : 0" << std::endl;
+    std::cout << "Calculated    : " << batch[2].to_string() << std::endl;
+    std::cout << "Expected      : 7870185709733630213048715712406899918656739937453536376977843919577332722390227777300415677532372018119095410975325379313027907239154215217974440932567605" << std::endl;
+
+    // Batch modular multiplication test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Batch   : num3 * num4, num7 * num4, num9 * num3" << std::endl;
+    std::cout << "modulus : 2048bits odd (batch)" << std::endl;
+    BigNumber batch_left[] = {num3, num7, num9};
+    BigNumber batch_right[] = {num4, num4, num3};
+    BigNumber batch_products[3];
+    BigNumber::batchModMul(batch_left, batch_right, batch_products, 3, mod_2048_odd);
+    std::cout << "Calculated    : " << batch_products[0].to_string() << std::endl;
+    std::cout << "Expected      : 1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+    std::cout << "Calculated    : " << batch_products[1].to_string() << std::endl;
+    std::cout << "Expected      : -1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+    std::cout << "Calculated    : " << batch_products[2].to_string() << std::endl;
+    std::cout << "Expected      : -1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+
+    // Parallel batch test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    BatchExecutor executor(2);
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Batch   : num3 * num4, num7 * num4, num9 * num3 on " << executor.threadCount() << " threads" << std::endl;
+    std::cout << "modulus : 2048bits odd (batch)" << std::endl;
+    BigNumber parallel_products[3];
+    executor.modMultiplication(batch_left, batch_right, parallel_products, 3, mod_2048_odd);
+    std::cout << "Calculated    : " << parallel_products[0].to_string() << std::endl;
+    std::cout << "Expected      : 1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+    std::cout << "Calculated    : " << parallel_products[1].to_string() << std::endl;
+    std::cout << "Expected      : -1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+    std::cout << "Calculated    : " << parallel_products[2].to_string() << std::endl;
+    std::cout << "Expected      : -1902630407448888581152563811087073607384841996765443239617645039476763042163795236214213745445530792695039076077056305319410900811651992518529653325670836621178831463284317957434328133809496274186450111917558233056131892905902929832611495577155137176369795097381209917922498772437531957474654386875832999332393571011245126728073126270547865506886898931648575786142228462790063903613097346756639775510335193992369690241048507612389550309796541782512105461716123683665093813073373870205922817059001006033139500163256704070660600520893354827774753188902554849369724568868613625798330095617379444925807405859054606821521" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Batch   : num1, num0, num2 (inverse, asynchronous)" << std::endl;
+    std::cout << "modulus : 512bits" << std::endl;
+    BigNumber parallel_inputs[] = {num1, num0, num2};
+    BigNumber parallel_inverses[3];
+    std::future<size_t> parallel_failures = executor.modInverseAsync(parallel_inputs, parallel_inverses, 3, mod_512);
+    std::cout << "Calculated    : " << parallel_failures.get() << std::endl;
+    std::cout << "Expected      : 1" << std::endl;
+    std::cout << "Calculated    : " << parallel_inverses[0].to_string() << std::endl;
+    std::cout << "Expected      : 9147482900272338539705261019175300624143989181826741864596824711264600130384856868068663746785895787813079850763254056636409668114587263601063751447537857" << std::endl;
+    std::cout << "Calculated    : " << parallel_inverses[1].to_string() << std::endl;
+    std::cout << "Expected      : 0" << std::endl;
+    std::cout << "Calculated    : " << parallel_inverses[2].to_string() << std::endl;
+    std::cout << "Expected      : 7870185709733630213048715712406899918656739937453536376977843919577332722390227777300415677532372018119095410975325379313027907239154215217974440932567605" << std::endl;
+
+    // RSA test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    RsaPrivateKey rsa_key(BigNumber("10975394594885697276513051713512165257658996229542633769603571581473829918433809450044957309092308614078925693256700264372009025235779464985957805349423021"),
+                          BigNumber("13250372257513130919854022974452131820337694306399691043269947311347634714041794238041165606944197078232859698824640446732969611774519549173034577792084579"),
+                          BigNumber("106000475942737730309074083196410818252999748493785852091676376857080522744163732929788864129708621036702077784707090619067238058413055393269869811377351861733819038145590950753446460047266729347844506328047777083308545528650702431485281692654272893289550650531517922964374394943376066097865130947798867591193"));
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    BigNumber rsa_input("11341941341236836545955325737038029045248519134081727529702947760850237023973962675717237261287710996389772875073697878226092691855285595318390697810559280994607322394610000804625844616627430801171498217674555369189858669517488746099218216317640804920239116346561032305753356327685960614167921105317273530605");
+    std::cout << "Number 1: " << rsa_input.to_string() << std::endl;
+    std::cout << "RSA     : 1024bits private operation (CRT)" << std::endl;
+    std::cout << "Calculated    : " << rsa_key.privateOperation(rsa_input).to_string() << std::endl;
+    std::cout << "Expected      : 24836923906012609482091729857095646566744950408484008171755056237091591680824515271504900127561931407182307428850864581592310165302971812789112680484914446656941065371002931754836706006800439272003772121995407115540465920576282047154975281056497566980258641586086931936484977382887785756039151784595508023480" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "RSA     : 1024bits private operation (CRT, batch of three)" << std::endl;
+    BigNumber rsa_inputs[] = {rsa_input,
+                              BigNumber("5794026804992184528526550793276895856772885631304136094231459485981628083086623445493166264079670918234938350212251213041950632628141768368580187534496080645605596462804343516900278772884147547925588316379147672010139524470436602623551265427954421753592863340209797868358714826350772730440813839847599610175"),
+                              BigNumber("100572157019147369378468749413205246945555212183321178803576487963601825522447204808441301784511081278287764369335992299817110137185987075039808245049169738518233701074790579763799639675347880978001456861224846649047872956932024217863840111705487399442015928681075938079379630370210461397700213703200830176247")};
+    BigNumber rsa_outputs[3];
+    rsa_key.privateOperation(rsa_inputs, rsa_outputs, 3);
+    std::cout << "Calculated    : " << rsa_outputs[0].to_string() << std::endl;
+    std::cout << "Expected      : 24836923906012609482091729857095646566744950408484008171755056237091591680824515271504900127561931407182307428850864581592310165302971812789112680484914446656941065371002931754836706006800439272003772121995407115540465920576282047154975281056497566980258641586086931936484977382887785756039151784595508023480" << std::endl;
+    std::cout << "Calculated    : " << rsa_outputs[1].to_string() << std::endl;
+    std::cout << "Expected      : 89955903085093880861007677546087558695354698692042224447826992298005293309796335161923364757118394192464191413454126927282570372043239282721776550822353342257246220101426287143867065420747566607579495167520098206104316364696445538433186908613632699324282676271601217825193713190256018308323734364966696781769" << std::endl;
+    std::cout << "Calculated    : " << rsa_outputs[2].to_string() << std::endl;
+    std::cout << "Expected      : 127829105153769243121525737788292776166886287944516698928372035841369180864507022855713731361559297122450056631777486953752517746484233733965370541313039385239702764559936861787676327169572163597948862305542366645249792037946466329754791997117640004498706011008918453579095165546835958438714948727778748184496" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "RSA     : 1024bits private operation (CRT, blinded and checked with e = 65537)" << std::endl;
+    RsaPrivateKey rsa_blinded_key(BigNumber("10975394594885697276513051713512165257658996229542633769603571581473829918433809450044957309092308614078925693256700264372009025235779464985957805349423021"),
+                                  BigNumber("13250372257513130919854022974452131820337694306399691043269947311347634714041794238041165606944197078232859698824640446732969611774519549173034577792084579"),
+                                  BigNumber("106000475942737730309074083196410818252999748493785852091676376857080522744163732929788864129708621036702077784707090619067238058413055393269869811377351861733819038145590950753446460047266729347844506328047777083308545528650702431485281692654272893289550650531517922964374394943376066097865130947798867591193"),
+                                  BigNumber(65537));
+    std::cout << "Calculated    : " << rsa_blinded_key.privateOperation(rsa_input).to_string() << std::endl;
+    std::cout << "Expected      : 24836923906012609482091729857095646566744950408484008171755056237091591680824515271504900127561931407182307428850864581592310165302971812789112680484914446656941065371002931754836706006800439272003772121995407115540465920576282047154975281056497566980258641586086931936484977382887785756039151784595508023480" << std::endl;
+    BigNumber rsa_blinded_outputs[3];
+    rsa_blinded_key.privateOperation(rsa_inputs, rsa_blinded_outputs, 3);
+    std::cout << "Calculated    : " << (rsa_blinded_outputs[0] == rsa_outputs[0]) << (rsa_blinded_outputs[1] == rsa_outputs[1])
+              << (rsa_blinded_outputs[2] == rsa_outputs[2]) << std::endl;
+    std::cout << "Expected      : 111" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "RSA     : 1024bits private operation with a wrong public exponent (e = 3)" << std::endl;
+    RsaPrivateKey rsa_wrong_key(BigNumber("10975394594885697276513051713512165257658996229542633769603571581473829918433809450044957309092308614078925693256700264372009025235779464985957805349423021"),
+                                BigNumber("13250372257513130919854022974452131820337694306399691043269947311347634714041794238041165606944197078232859698824640446732969611774519549173034577792084579"),
+                                BigNumber("106000475942737730309074083196410818252999748493785852091676376857080522744163732929788864129708621036702077784707090619067238058413055393269869811377351861733819038145590950753446460047266729347844506328047777083308545528650702431485281692654272893289550650531517922964374394943376066097865130947798867591193"),
+                                BigNumber(3));
+    std::string rsa_wrong_text;
+    try
+    {
+        rsa_wrong_text = rsa_wrong_key.privateOperation(rsa_input).to_string();
+    }
+    catch (const std::runtime_error &)
+    {
+        rsa_wrong_text = "Check failed";
+    }
+    std::cout << "Calculated    : " << rsa_wrong_text << std::endl;
+    std::cout << "Expected      : Check failed" << std::endl;
+
+    // Primality test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << mod_512_odd.to_string() << std::endl;
+    std::cout << "Number 2: " << num1.to_string() << std::endl;
+    std::cout << "Primes  : isProbablePrime" << std::endl;
+    std::cout << "Calculated    : " << mod_512_odd.isProbablePrime() << num1.isProbablePrime() << std::endl;
+    std::cout << "Expected      : 10" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Primes  : generatePrime(256), bit length and primality" << std::endl;
+    BigNumber generated_prime = BigNumber::generatePrime(256, executor);
+    std::cout << "Calculated    : " << generated_prime.bitLength() << generated_prime.isProbablePrime() << std::endl;
+    std::cout << "Expected      : 2561" << std::endl;
+
+    // Large operand test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: 10^200000 - 1" << std::endl;
+    std::cout << "Square  : (transform), compared with 9..980..01 in decimal" << std::endl;
+    const BigNumber nines(std::string(200000, '9'));
+    const BigNumber nines_square = nines * nines;
+    std::cout << "Calculated    : "
+              << (nines_square.to_string() == std::string(199999, '9') + "8" + std::string(199999, '0') + "1") << std::endl;
+    std::cout << "Expected      : 1" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: (10^200000 - 1)^2 + 10^200000 - 2" << std::endl;
+    std::cout << "Number 2: 10^200000 - 1" << std::endl;
+    std::cout << "Division: (Newton), quotient and remainder" << std::endl;
+    const auto nines_division = (nines_square + nines - BigNumber(1)).divide(nines);
+    std::cout << "Calculated    : " << (nines_division.first == nines) << (nines_division.second == nines - BigNumber(1))
+              << std::endl;
+    std::cout << "Expected      : 11" << std::endl;
+
+    // Allocation test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num2.to_string() << std::endl;
+    std::cout << "modulus : 512bits (allocations in a warm modMultiplication loop)" << std::endl;
+    BigNumber loop_product;
+    num1.modMultiplication(num2, mod_512, loop_product);
+    BigNumber::AllocationCounter loop_allocations;
+    for (int i = 0; i < 100; ++i)
+    {
+        loop_product.modMultiplication(num2, mod_512, loop_product);
+    }
+    std::cout << "Calculated    : " << loop_allocations.allocations() << std::endl;
+    std::cout << "Expected      : 0" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num5.to_string() << std::endl;
+    std::cout << "to_string inside an arena scope and again after it, on a thread with cold decimal caches" << std::endl;
+    std::string arena_text, after_arena_text;
+    std::thread arena_thread([&]() {
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            BigNumber::LimbResourceScope scope(&arena);
+            arena_text = num5.to_string();
+        }
+        after_arena_text = num5.to_string();
+    });
+    arena_thread.join();
+    std::cout << "Calculated    : " << (arena_text == num5.to_string()) << (after_arena_text == num5.to_string()) << std::endl;
+    std::cout << "Expected      : 11" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: 24000 sevens" << std::endl;
+    std::cout << "to_string (Newton division) inside an arena scope and again after it, on a thread with cold caches" << std::endl;
+    const std::string sevens(24000, '7');
+    const BigNumber sevens_value(sevens);
+    std::string arena_sevens, after_arena_sevens;
+    std::thread arena_sevens_thread([&]() {
+        {
+            std::pmr::monotonic_buffer_resource arena;
+            BigNumber::LimbResourceScope scope(&arena);
+            arena_sevens = sevens_value.to_string();
+        }
+        after_arena_sevens = sevens_value.to_string();
+    });
+    arena_sevens_thread.join();
+    std::cout << "Calculated    : " << (arena_sevens == sevens) << (after_arena_sevens == sevens) << std::endl;
+    std::cout << "Expected      : 11" << std::endl;
+
+    // Predicate test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num0.to_string() << std::endl;
+    std::cout << "Calculated    : " << num0.isZero() << num0.isOne() << std::endl;
+    std::cout << "Expected      : 10" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num10.to_string() << std::endl;
+    std::cout << "Calculated    : " << num10.isZero() << num10.isOne() << std::endl;
+    std::cout << "Expected      : 01" << std::endl;
+
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << (-num10).to_string() << std::endl;
+    std::cout << "Calculated    : " << (-num10).isZero() << (-num10).isOne() << std::endl;
+    std::cout << "Expected      : 00" << std::endl;
+
+    // Instrumentation test cases
+
+    std::cout << "===========================================================================================" << std::endl;
+    std::cout << "-------------------------------------------------------------------------------------------" << std::endl;
+    std::cout << "Number 1: " << num1.to_string() << std::endl;
+    std::cout << "Number 2: " << num0.to_string() << std::endl;
+    std::cout << "Counters: multiply calls and division by zero events (zero unless built with BIGNUMBER_INSTRUMENTATION)" << std::endl;
+    BigNumber::resetStatistics();
+    BigNumber counted_product = num1 * num1;
+    BigNumber counted_quotient = num1 / num0;
+    const BigNumber::Statistics counted = BigNumber::statistics();
+    std::cout << "Calculated    : " << counted[BigNumber::Operation::Multiply].calls << counted.division_by_zero << std::endl;
+    std::cout << "Expected      : " << (BigNumber::instrumentationEnabled ? "11" : "00") << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}